@@ -0,0 +1,324 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <ctime>
+#include <future>
+#include <thread>
+#include <memory>
+#include <vector>
+
+// Include Argument Parser
+#include "args.hxx"
+// Include TCP client
+#include "tcpclient.h"
+#include "tcpclientapp.h"
+#include "tcpechoserver.h"
+
+namespace {
+/// Percentiles of latencies in the results
+const double benchPercents[] = { 50, 99 };
+
+/// One point of the matrix
+struct BenchCase {
+    uint32_t blockSize_;
+    int nSockets_;
+    bool isDuplex_;
+};
+
+/// Result of all repetitions of one point
+struct BenchResult {
+    BenchCase case_;
+    uint64_t payloadBytes_;
+    uint64_t blocks_;
+    double seconds_;
+    double cpuSeconds_;
+    LatencyHistogram send_;
+    LatencyHistogram rcv_;
+    bool ok_;
+    BenchResult() : case_{ 0, 0, false }, payloadBytes_(0), blocks_(0), seconds_(0), cpuSeconds_(0), ok_(true) {}
+    double mb_per_s() const
+    {
+        return seconds_ > 0 ? double(payloadBytes_) / seconds_ / 1e6 : 0;
+    }
+    double blocks_per_s() const
+    {
+        return seconds_ > 0 ? double(blocks_) / seconds_ : 0;
+    }
+    /// CPU seconds of process (client and local server) per GB of payload sent and received back
+    double cpu_per_gb() const
+    {
+        return payloadBytes_ > 0 ? cpuSeconds_ / (double(payloadBytes_) / 1e9) : 0;
+    }
+};
+
+/// CPU time of all threads of process, seconds
+double cpuSeconds()
+{
+    return double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+/// std::cout of library and server is dropped while the transfers are measured
+class QuietCout
+{
+public:
+    explicit QuietCout(const bool quiet) : old_(quiet ? std::cout.rdbuf(null_.rdbuf()) : nullptr) {}
+    ~QuietCout()
+    {
+        if (old_) {
+            std::cout.rdbuf(old_);
+        }
+    }
+
+private:
+    std::ostringstream null_;
+    std::streambuf *old_;
+};
+
+/**
+ * @brief Transfers of data through one connection: sendData() and receiveToData() together, "repeat" times
+ * @param connectionInfo - address of server and the options of client, the block size and sockets are of server
+ */
+void runCase(const BenchCase &benchCase, ConnectionInfo connectionInfo, const size_t dataBytes, const int repeat,
+             const bool useLocalServer, BenchResult &result)
+{
+    result.case_ = benchCase;
+
+    std::unique_ptr<EchoServer> server;
+    std::thread serverThread;
+    if (useLocalServer) {
+        EchoServerConfig config;
+        config.port_ = 0;
+        config.blockSize_ = benchCase.blockSize_;
+        config.nSockets_ = static_cast<uint8_t>(benchCase.nSockets_);
+        config.isDuplexSockets_ = benchCase.isDuplex_;
+        config.once_ = true;
+        server.reset(new EchoServer(config));
+        if (!server->listen()) {
+            result.ok_ = false;
+            return;
+        }
+        connectionInfo.port_ = server->port();
+        serverThread = std::thread(&EchoServer::run, server.get());
+    }
+    connectionInfo.tcpBufSize_ = benchCase.blockSize_;
+    connectionInfo.nSockets_ = static_cast<uint8_t>(benchCase.nSockets_);
+    connectionInfo.isDuplexSockets_ = benchCase.isDuplex_;
+    connectionInfo.exit_ = false;
+
+    TCPClient client;
+    if (!client.initConnection(connectionInfo) || !client.connect()) {
+        result.ok_ = false;
+    } else {
+        // the block size and the sockets are taken from the socketconfig block of server
+        const auto &info = client.get_connection_info();
+        result.case_ = BenchCase{ info.tcpBufSize_, int(info.nSockets_), info.isDuplexSockets_ };
+
+        std::vector<uint64_t> dataIn(dataBytes / sizeof(uint64_t));
+        for (size_t i = 0; i < dataIn.size(); ++i) {
+            dataIn[i] = i * 0x9E3779B97F4A7C15ull;
+        }
+        std::vector<uint64_t> dataOut(dataIn.size() + info.tcpBufSize_ / sizeof(uint64_t));
+        for (int i = 0; i < repeat && result.ok_; ++i) {
+            dataOut.resize(dataIn.size() + info.tcpBufSize_ / sizeof(uint64_t));
+            const auto cpu_start = cpuSeconds();
+            const auto t_start = std::chrono::steady_clock::now();
+            auto f_rcv = std::async(std::launch::async, TCPClientApp::receiveToData, std::ref(client), std::ref(dataOut));
+            const bool sent = TCPClientApp::sendData(client, dataIn);
+            const auto rcvBytes = f_rcv.get();
+            result.seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+            result.cpuSeconds_ += cpuSeconds() - cpu_start;
+            result.payloadBytes_ += rcvBytes;
+            result.blocks_ += client.get_bytes_sent() / info.tcpBufSize_;
+            for (const auto &state : client.get_socket_states()) {
+                if (state) {
+                    result.send_.merge(state->sendLatency_);
+                    result.rcv_.merge(state->rcvLatency_);
+                }
+            }
+            result.ok_ = sent && client.get_error() == 0 && rcvBytes == dataBytes
+                         && std::equal(dataIn.begin(), dataIn.end(), dataOut.begin());
+            result.ok_ = client.finish_transfer() && result.ok_;
+        }
+    }
+    client.disconnect();
+    if (server) {
+        // the server of one connection is finished by the disconnect of client
+        server->stop();
+        serverThread.join();
+    }
+}
+
+std::string csvHeader()
+{
+    std::string header("block_size,n_sockets,duplex,payload_bytes,seconds,mb_per_s,blocks_per_s,cpu_s_per_gb");
+    for (const auto p : benchPercents) {
+        header += ",send_p" + utils::to_string(p) + "_ns";
+    }
+    for (const auto p : benchPercents) {
+        header += ",receive_p" + utils::to_string(p) + "_ns";
+    }
+    return header + ",ok";
+}
+
+std::string csvRow(const BenchResult &res)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3);
+    os << res.case_.blockSize_ << "," << res.case_.nSockets_ << "," << (res.case_.isDuplex_ ? 1 : 0) << ","
+       << res.payloadBytes_ << "," << res.seconds_ << "," << res.mb_per_s() << "," << res.blocks_per_s() << ","
+       << res.cpu_per_gb();
+    for (const auto p : benchPercents) {
+        os << "," << res.send_.percentile(p);
+    }
+    for (const auto p : benchPercents) {
+        os << "," << res.rcv_.percentile(p);
+    }
+    os << "," << (res.ok_ ? 1 : 0);
+    return os.str();
+}
+
+std::string jsonObject(const BenchResult &res)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3);
+    os << "{\"block_size\": " << res.case_.blockSize_ << ", \"n_sockets\": " << res.case_.nSockets_
+       << ", \"duplex\": " << (res.case_.isDuplex_ ? "true" : "false") << ", \"payload_bytes\": " << res.payloadBytes_
+       << ", \"seconds\": " << res.seconds_ << ", \"mb_per_s\": " << res.mb_per_s() << ", \"blocks_per_s\": " << res.blocks_per_s()
+       << ", \"cpu_s_per_gb\": " << res.cpu_per_gb();
+    const std::pair<const char *, const LatencyHistogram *> latencies[] = { { "send", &res.send_ }, { "receive", &res.rcv_ } };
+    for (const auto &lat : latencies) {
+        os << ", \"" << lat.first << "_ns\": {\"count\": " << lat.second->count();
+        for (const auto p : benchPercents) {
+            os << ", \"p" << utils::to_string(p) << "\": " << lat.second->percentile(p);
+        }
+        os << ", \"max\": " << lat.second->max() << "}";
+    }
+    os << ", \"ok\": " << (res.ok_ ? "true" : "false") << "}";
+    return os.str();
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string appName(argv[0]);
+    appName = appName.substr(appName.find_last_of("\\/:") + 1);
+
+    args::ArgumentParser args_parser("Throughput of TCPClient over the matrix of block size, count of sockets and duplex mode.");
+    args_parser.helpParams.width = 130;
+    args_parser.helpParams.helpindent = 32;
+    args_parser.Prog(appName);
+    args_parser.LongSeparator(" ");
+    args::HelpFlag help(args_parser, "help", "Display this help menu", { 'h', "help" });
+    args::ValueFlag<std::string> host(args_parser, "hostname",
+                                      "External server, the matrix is one point of its configuration. Default is the local echo server",
+                                      { 'n' });
+    args::ValueFlag<int> port(args_parser, "port", "The number of port of external server. Default is 12340.", { 'p' }, 12340);
+    args::ValueFlagList<uint32_t> blockSizes(args_parser, "block_size", "Block size in bytes, repeated. Default is 128 1024 4096 16384 65536",
+                                             { 'b' }, { 128, 1024, 4096, 16384, 65536 });
+    args::ValueFlagList<int> nSockets(args_parser, "nSockets", "Quantity of sockets, repeated. Default is 1 2 4 8 16", { "n_sockets" },
+                                      { 1, 2, 4, 8, 16 });
+    args::Flag onlyDuplex(args_parser, "duplex", "Only duplex sockets.", { "duplex" });
+    args::Flag onlySplit(args_parser, "split", "Only sockets of one direction (the single socket is always duplex).", { "split" });
+    args::ValueFlag<uint32_t> dataMb(args_parser, "MB", "Data of every transfer, MB. Default is 16", { "data_mb" }, 16);
+    args::ValueFlag<int> repeat(args_parser, "N", "Transfers of every point. Default is 3", { "repeat" }, 3);
+    args::MapFlag<std::string, IoMode> io_mode(args_parser, "mode", "I/O engine: blocking|epoll|io_uring|threads. Default is blocking",
+                                               { "io_mode" }, utils::typesOfIoMode, IoMode::Blocking);
+    args::ValueFlag<std::string> csv(args_parser, "file", "Results in CSV.", { "csv" });
+    args::ValueFlag<std::string> json(args_parser, "file", "Results in JSON.", { "json" });
+    args::Flag verbose(args_parser, "verbose", "Print the output of client and server.", { "verbose" });
+
+    try {
+        args_parser.ParseCLI(argc, argv);
+        if (onlyDuplex && onlySplit) {
+            throw (args::ValidationError("--duplex and --split are exclusive."));
+        }
+    } catch (args::Help) {
+        std::cout << args_parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << "Not valid input argument(s).\n" << e.what() << std::endl;
+        std::cerr << "\nUse ./" << appName << " -h for help." << std::endl;
+        return 2;
+    } catch (args::ValidationError e) {
+        std::cerr << "Not valid input argument(s).\n" << e.what() << std::endl;
+        std::cerr << "\nUse ./" << appName << " -h for help." << std::endl;
+        return 3;
+    }
+
+    const bool useLocalServer = !host;
+    std::vector<BenchCase> cases;
+    if (useLocalServer) {
+        for (const auto blockSize : blockSizes.Get()) {
+            for (const auto n : nSockets.Get()) {
+                if (n < 1 || n > 255) {
+                    continue;
+                }
+                if (!onlySplit || 1 == n) {
+                    cases.push_back(BenchCase{ blockSize, n, true });
+                }
+                if (!onlyDuplex && n > 1 && 0 == n % 2) {
+                    cases.push_back(BenchCase{ blockSize, n, false });
+                }
+            }
+        }
+    } else {
+        // the configuration is sent by the server
+        cases.push_back(BenchCase{ 0, 0, false });
+    }
+
+    ConnectionInfo connectionInfo;
+    connectionInfo.remoteAddress_ = useLocalServer ? "127.0.0.1" : host.Get();
+    connectionInfo.port_ = port.Get();
+    connectionInfo.ioMode_ = io_mode.Get();
+    connectionInfo.instrumentMode_ = InstrumentMode::Full;
+    const size_t dataBytes = size_t(dataMb.Get()) * 1000 * 1000 / sizeof(uint64_t) * sizeof(uint64_t);
+
+    std::cout << std::left << std::setw(11) << "block_size" << std::setw(10) << "sockets" << std::setw(8) << "duplex"
+              << std::setw(11) << "MB/s" << std::setw(13) << "blocks/s" << std::setw(11) << "CPU s/GB"
+              << std::setw(13) << "send p99 ns" << std::setw(13) << "rcv p99 ns" << "ok" << std::endl;
+    // the histograms are not copyable, the results stay in place
+    std::vector<std::unique_ptr<BenchResult>> results;
+    int error(0);
+    for (const auto &benchCase : cases) {
+        results.emplace_back(new BenchResult());
+        auto &res = *results.back();
+        {
+            QuietCout quiet(!verbose);
+            runCase(benchCase, connectionInfo, dataBytes, std::max(1, repeat.Get()), useLocalServer, res);
+        }
+        std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(11) << res.case_.blockSize_ << std::setw(10)
+                  << res.case_.nSockets_ << std::setw(8) << (res.case_.isDuplex_ ? "yes" : "no") << std::setw(11) << res.mb_per_s()
+                  << std::setw(13) << res.blocks_per_s() << std::setprecision(3) << std::setw(11) << res.cpu_per_gb()
+                  << std::setw(13) << res.send_.percentile(99) << std::setw(13) << res.rcv_.percentile(99) << (res.ok_ ? "yes" : "NO") << std::endl;
+        error = res.ok_ ? error : 4;
+    }
+
+    if (csv) {
+        std::ofstream ofs(csv.Get(), std::ofstream::out | std::ofstream::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "File \"" << csv.Get() << "\" not created." << std::endl;
+            return 5;
+        }
+        ofs << csvHeader() << "\n";
+        for (const auto &res : results) {
+            ofs << csvRow(*res) << "\n";
+        }
+    }
+    if (json) {
+        std::ofstream ofs(json.Get(), std::ofstream::out | std::ofstream::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "File \"" << json.Get() << "\" not created." << std::endl;
+            return 5;
+        }
+        ofs << "{\"io_mode\": \"" << utils::name_of(utils::typesOfIoMode, connectionInfo.ioMode_) << "\", \"data_bytes\": " << dataBytes
+            << ", \"repeat\": " << std::max(1, repeat.Get()) << ", \"local_server\": " << (useLocalServer ? "true" : "false")
+            << ", \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            ofs << "  " << jsonObject(*results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        ofs << "]}\n";
+    }
+    return error;
+}
@@ -14,6 +14,9 @@
 // Include TCP client
 #include "tcpclient.h"
 #include "tcpclientapp.h"
+#include "tcpautotune.h"
+#include "tcpmetrics.h"
+#include "tcptrace.h"
 
 
 uint64_t receiveQuickData(TCPClient &client, std::vector<uint64_t> &dataOut)
@@ -99,8 +102,11 @@ int main(int argc, char *argv[])
     args::ValueFlag<int> port(g_send_required, "port", "The number of port. Default is 12340.", { 'p' }, 12340);
     // data options
     args::Group g_data(g_send_required, "Data options:", args::Group::Validators::AtLeastOne);
-    args::ValueFlag<std::string> data_file(g_data, "data_file",
-                                           "Send data from file filename. Data retrieved save to file fileName+\".out\"", { 'f' });
+    args::ValueFlagList<std::string> data_file(g_data, "data_file",
+                                               "Send data from file filename. Data retrieved save to file fileName+\".out\". "
+                                               "Several files are sent one after another over one connection", { 'f' });
+    args::ValueFlag<uint64_t> ping(g_data, "count",
+                                   "Send <count> single blocks with sequence number and time of sending, print the round trip", { "ping" });
     // send options
     args::Group g_send(args_parser, "Send options:", args::Group::Validators::DontCare);
     args::MapFlag<std::string, utils::convertors::FileType> type(g_send, "type", "Type of input file", { "type" },
@@ -116,6 +122,63 @@ int main(int argc, char *argv[])
     args::ValueFlag<int> timeOut(g_send, "sec", "Time out for wait send/receive operations, seconds. Default is 0", { "time_out" },
                                  0);
     args::ValueFlag<int> wait_connect(g_send, "sec", "Waiting of TCP connection, seconds. Default is 0", { "wait_connect" }, 0);
+    args::ValueFlag<int> connect_retry(g_send, "msec", "First pause before retry of connect, doubled after every retry. Default is 10",
+                                       { "connect_retry_ms" }, 10);
+    args::MapFlag<std::string, IoMode> io_mode(g_send, "mode", "I/O engine: blocking|epoll|io_uring|threads. Default is blocking", { "io_mode" },
+                                               utils::typesOfIoMode, IoMode::Blocking);
+    args::MapFlag<std::string, SchedulerType> scheduler(g_send, "scheduler",
+                                                        "Choice of send socket: rr|least_loaded|weighted (by throughput of sockets which is measured by "
+                                                        "queues of engine and SIOCOUTQ, independent of --instrument). Default is rr",
+                                                        { "scheduler" }, utils::typesOfScheduler, SchedulerType::RoundRobin);
+    args::MapFlag<std::string, InstrumentMode> instrument(g_send, "instrument",
+                                                          "Timing of send/receive operations: off|sampled|full. Default is full",
+                                                          { "instrument" }, utils::typesOfInstrument, InstrumentMode::Full);
+    args::ValueFlag<uint32_t> sample_rate(g_send, "N", "One of N operations is timed by --instrument sampled. Default is 64",
+                                          { "sample_rate" }, 64);
+    args::ValueFlag<uint32_t> window(g_send, "blocks", "Max blocks sent and not received back, 0 - no limit. Default is 0",
+                                     { "window" }, 0);
+    args::ValueFlag<uint64_t> window_bytes(g_send, "bytes", "Max bytes sent and not received back, overrides --window",
+                                           { "window_bytes" }, 0);
+    args::ValueFlag<uint32_t> queue_depth(g_send, "blocks", "Queue (receive buffer) size of every socket in blocks. Default is 16",
+                                          { "queue_depth" }, 16);
+    args::Flag zerocopy(g_send, "zerocopy", "Send blocks with MSG_ZEROCOPY (blocking I/O only)", { "zerocopy" });
+    args::ValueFlag<uint32_t> zerocopy_min(g_send, "bytes", "Blocks smaller than this size are copied. Default is 16384",
+                                           { "zerocopy_min" }, 16384);
+    args::ValueFlag<uint32_t> pipeline_depth(g_send, "blocks",
+                                             "Blocks read ahead from file by reader thread, 0 - no reader thread. Default is 8",
+                                             { "pipeline_depth" }, 8);
+    args::MapFlag<std::string, int> sock_profile(g_send, "profile", "Preset of TCP options: default|throughput|latency. Default is default",
+                                                 { "sock_profile" }, { { "default", 0 }, { "throughput", 1 }, { "latency", 2 } }, 0);
+    args::Flag nodelay(g_send, "nodelay", "Set TCP_NODELAY", { "nodelay" });
+    args::Flag cork(g_send, "cork", "Set TCP_CORK, the tail of data is pushed at end of transfer", { "cork" });
+    args::ValueFlag<int> notsent_lowat(g_send, "bytes", "TCP_NOTSENT_LOWAT of sockets, 0 - system default", { "notsent_lowat" });
+    args::ValueFlag<std::string> congestion(g_send, "name", "TCP congestion control (e.g. bbr, cubic)", { "congestion" });
+    args::ValueFlag<int> busy_poll(g_send, "usec", "SO_BUSY_POLL of sockets, 0 - off", { "busy_poll" });
+    args::ValueFlag<uint32_t> bandwidth(g_send, "Mbit/s", "Bandwidth of link, socket buffers are sized to bandwidth x RTT", { "bandwidth_mbps" });
+    args::ValueFlag<uint32_t> rtt(g_send, "usec", "Round trip time of link for sizing of socket buffers", { "rtt_us" });
+    args::ValueFlag<uint32_t> autotune(g_send, "MB",
+                                       "Probe I/O modes and queue depths by transfers of <MB> megabytes, the fastest is used and cached",
+                                       { "autotune" });
+    args::ValueFlag<std::string> tune_cache(g_send, "file", "Cache file of autotune results. Default is $HOME/.tcp_client_tune",
+                                            { "tune_cache" });
+    args::ValueFlag<std::string> metrics_file(g_send, "file", "Write metrics in Prometheus text format to file every interval",
+                                              { "metrics_file" });
+    args::ValueFlag<int> metrics_port(g_send, "port", "Serve metrics in Prometheus text format on http://127.0.0.1:<port>/metrics",
+                                      { "metrics_port" });
+    args::ValueFlag<int> metrics_interval(g_send, "msec", "Interval of writing of metrics file and of throughput. Default is 1000",
+                                          { "metrics_interval" }, 1000);
+    args::ValueFlag<std::string> report(g_send, "file", "Write report of run in JSON to file at exit", { "report" });
+    args::MapFlag<std::string, CompressionCodec> compress(g_send, "codec",
+                                                          "Compression of payloads of blocks: none|lz4|zstd, used if the server "
+                                                          "advertises the codec. Default is none",
+                                                          { "compress" }, utils::typesOfCompression, CompressionCodec::Uncompressed);
+    args::ValueFlag<int> compress_level(g_send, "level", "Level of zstd, acceleration of lz4. Default is 1", { "compress_level" }, 1);
+    args::ValueFlag<uint32_t> compress_threads(g_send, "N", "Threads of compression of send pipeline, 0 - one per core. Default is 0",
+                                               { "compress_threads" }, 0);
+    args::ValueFlag<uint32_t> ping_rate(g_send, "blocks/s", "Rate of sending of --ping blocks, 0 - next block after echo. Default is 0",
+                                        { "ping_rate" }, 0);
+    args::ValueFlag<std::string> trace(g_send, "file", "Write timeline of send/receive in Chrome trace-event JSON to file at exit",
+                                       { "trace" });
     args::Flag print(g_send, "print", "Turn on print option", { 'P' });
     args::Flag term(g_send, "term", "Terminate the server", { 't' });
     g_data.Add(term);
@@ -183,8 +246,130 @@ int main(int argc, char *argv[])
             connectionInfo.delayAfterConnect_ = delay_after_connect.Get();
             connectionInfo.timeOut_ = timeOut.Get();
             connectionInfo.waitConnect_ = wait_connect.Get();
-            if (data_file) {
-                std::string dataFile(data_file.Get());
+            connectionInfo.connectRetryMs_ = connect_retry.Get();
+            connectionInfo.ioMode_ = io_mode.Get();
+            connectionInfo.ioQueueDepth_ = std::max<uint32_t>(1, queue_depth.Get());
+            connectionInfo.scheduler_ = scheduler.Get();
+            connectionInfo.windowBlocks_ = window.Get();
+            connectionInfo.instrumentMode_ = instrument.Get();
+            connectionInfo.instrumentSampleRate_ = std::max<uint32_t>(1, sample_rate.Get());
+            connectionInfo.windowBytes_ = window_bytes.Get();
+            connectionInfo.zeroCopy_ = zerocopy;
+            connectionInfo.zeroCopyMinSize_ = zerocopy_min.Get();
+            connectionInfo.pipelineDepth_ = pipeline_depth.Get();
+            connectionInfo.compression_ = compress.Get();
+            connectionInfo.compressionLevel_ = compress_level.Get();
+            connectionInfo.compressThreads_ = compress_threads.Get();
+            // the options override the values of preset
+            auto &sockOpt = connectionInfo.socketOptions_;
+            if (1 == sock_profile.Get()) {
+                sockOpt = SocketOptions::throughput();
+            } else if (2 == sock_profile.Get()) {
+                sockOpt = SocketOptions::latency();
+            }
+            sockOpt.noDelay_ = sockOpt.noDelay_ || nodelay;
+            sockOpt.cork_ = sockOpt.cork_ || cork;
+            if (notsent_lowat) {
+                sockOpt.notSentLowat_ = notsent_lowat.Get();
+            }
+            if (congestion) {
+                sockOpt.congestion_ = congestion.Get();
+            }
+            if (busy_poll) {
+                sockOpt.busyPollUs_ = busy_poll.Get();
+            }
+            if (bandwidth) {
+                sockOpt.bandwidthMbps_ = bandwidth.Get();
+            }
+            if (rtt) {
+                sockOpt.rttUs_ = rtt.Get();
+            }
+            {
+                const std::string cacheFile(tune_cache ? tune_cache.Get() : AutoTune::default_cache_file());
+                AutoTune::Result tuned;
+                if (autotune) {
+                    if (AutoTune::tune(connectionInfo, uint64_t(std::max<uint32_t>(1, autotune.Get())) << 20, tuned)) {
+                        AutoTune::save(cacheFile, connectionInfo, tuned);
+                        AutoTune::apply(tuned, connectionInfo);
+                    }
+                } else if (!io_mode && !queue_depth && AutoTune::load(cacheFile, connectionInfo, tuned)) {
+                    // the explicit options have priority over the cached calibration
+                    std::cout << "Cached I/O settings of " << connectionInfo.remoteAddress_ << ":" << connectionInfo.port_
+                              << " are used (" << tuned.gbps_ << " Gbit/s at calibration)" << std::endl;
+                    AutoTune::apply(tuned, connectionInfo);
+                }
+            }
+            if (trace) {
+                // the calibration transfers are not traced
+                Tracer::start(trace.Get());
+                Tracer::set_thread_name("main");
+            }
+            if (ping) {
+                TCPClient client;
+                connectionInfo.exit_ = false;
+                if (!client.initConnection(connectionInfo)) {
+                    std::cerr << "Init error\n";
+                    exit(0);
+                }
+                if (!client.connect()) {
+                    exit(0);
+                }
+                LatencyHistogram rtt;
+                if (!TCPClientApp::pingPong(client, ping.Get(), ping_rate.Get(), rtt) || !client.finish_transfer()) {
+                    error = 4;
+                }
+                if (term && client.get_error() == 0) {
+                    TCPClientApp::send_exit(client);
+                }
+            } else if (data_file && (data_file.Get().size() > 1 || metrics_file || metrics_port || report)) {
+                // one connection for all files, the sockets are not reconnected between the transfers,
+                // the exit tag is sent after the last file. The metrics and the report are taken of this client
+                TCPClient client;
+                connectionInfo.exit_ = false;
+                if (!client.initConnection(connectionInfo)) {
+                    std::cerr << "Init error\n";
+                    exit(0);
+                }
+                if (!client.connect()) {
+                    exit(0);
+                }
+                std::unique_ptr<MetricsExporter> exporter;
+                if (metrics_file || metrics_port) {
+                    exporter.reset(new MetricsExporter(client, metrics_file ? metrics_file.Get() : "",
+                                                       metrics_port ? metrics_port.Get() : 0, metrics_interval.Get()));
+                    if (!exporter->start()) {
+                        exporter.reset();
+                    }
+                }
+                RunReport runReport;
+                auto fileType = type ? type.Get() : utils::convertors::FileType::ds8;
+                for (const auto &dataFile : data_file.Get()) {
+                    const auto t_start = std::chrono::steady_clock::now();
+                    bool res(false);
+                    if (fileType == utils::convertors::FileType::bin) {
+                        res = TCPClientApp::sendBinFile(client, dataFile);
+                    } else if (fileType == utils::convertors::FileType::hex) {
+                        res = TCPClientApp::sendHexFile(client, dataFile);
+                    } else {
+                        res = TCPClientApp::sendDS8File(client, dataFile);
+                    }
+                    runReport.add_transfer(client, dataFile,
+                                           std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count(), res);
+                    if (!res || !client.finish_transfer()) {
+                        error = 4;
+                        break;
+                    }
+                }
+                // the client may be reconnected by send_exit()
+                exporter.reset();
+                if (report) {
+                    runReport.write(report.Get(), client);
+                }
+                if (term && client.get_error() == 0) {
+                    TCPClientApp::send_exit(client);
+                }
+            } else if (data_file) {
+                std::string dataFile(data_file.Get().front());
                 std::string dataFileOut("");
                 if ("STDIN" == utils::str_to_upper(dataFile)) {
                     dataFileOut = "STDOUT";
@@ -270,6 +455,8 @@ int main(int argc, char *argv[])
         } // if (cmd_convert)
 
     } while (false);
+    // the threads of transfers are finished here
+    Tracer::stop();
 
     return error;
 }
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <string>
+
+// Include Argument Parser
+#include "args.hxx"
+// Include loopback server
+#include "tcpechoserver.h"
+
+int main(int argc, char *argv[])
+{
+    int error(0);
+
+    std::string appName(argv[0]);
+    appName = appName.substr(appName.find_last_of("\\/:") + 1);
+
+    args::ArgumentParser args_parser("Loopback stand-in of tcp_io_block: sends every block back to the client.");
+    args_parser.helpParams.width = 130;
+    args_parser.helpParams.helpindent = 32;
+    args_parser.Prog(appName);
+    args_parser.LongSeparator(" ");
+    args::HelpFlag help(args_parser, "help", "Display this help menu", { 'h', "help" });
+    args::ValueFlag<std::string> host(args_parser, "address", "Address of listening. Default is 127.0.0.1", { 'n' }, "127.0.0.1");
+    args::ValueFlag<int> port(args_parser, "port", "The number of port, 0 - any free port. Default is 12340.", { 'p' }, 12340);
+    args::ValueFlag<uint32_t> blockSize(args_parser, "block_size", "TCP Buffer size in bytes. Default is " + std::to_string(4096), { 'b' },
+                                        4096);
+    args::ValueFlag<int> nSockets(args_parser, "nSockets", "Quantity of sockets for connection. Default is 1", { "n_sockets" }, 1);
+    args::Flag duplex(args_parser, "duplexSockets", "Type of using socket.", { "duplex" });
+    args::ValueFlag<uint32_t> delay(args_parser, "usec", "Delay of processing of every block, microseconds. Default is 0",
+                                    { "delay_us" }, 0);
+    args::ValueFlag<uint32_t> bandwidth(args_parser, "Mbit/s", "Limit of sending of all sockets, Mbit/s, 0 - no limit. Default is 0",
+                                        { "bandwidth_mbps" }, 0);
+    args::Flag once(args_parser, "once", "Serve one connection and exit.", { "once" });
+    args::MapFlagList<std::string, uint64_t> codecs(args_parser, "codec",
+                                                    "Codec of compressed blocks advertised to client, repeated: none|lz4|zstd. "
+                                                    "Default is lz4 zstd", { "codec" },
+                                                    { { "none", 0 }, { "lz4", compression::bit(CompressionCodec::Lz4) },
+                                                      { "zstd", compression::bit(CompressionCodec::Zstd) } });
+
+    try {
+        args_parser.ParseCLI(argc, argv);
+        if (nSockets.Get() < 1 || nSockets.Get() > 255 || (!duplex && nSockets.Get() > 1 && nSockets.Get() % 2)) {
+            throw (args::ValidationError("Wrong parameters of sockets."));
+        }
+    } catch (args::Help) {
+        std::cout << args_parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << "Not valid input argument(s).\n" << e.what() << std::endl;
+        std::cerr << "\nUse ./" << appName << " -h for help." << std::endl;
+        return 2;
+    } catch (args::ValidationError e) {
+        std::cerr << "Not valid input argument(s).\n" << e.what() << std::endl;
+        std::cerr << "\nUse ./" << appName << " -h for help." << std::endl;
+        return 3;
+    }
+
+    EchoServerConfig config;
+    config.address_ = host.Get();
+    config.port_ = port.Get();
+    config.blockSize_ = blockSize.Get();
+    config.nSockets_ = static_cast<uint8_t>(nSockets.Get());
+    config.isDuplexSockets_ = duplex || 1 == nSockets.Get();
+    config.delayUs_ = delay.Get();
+    config.bandwidthMbps_ = bandwidth.Get();
+    config.once_ = once;
+    if (codecs) {
+        config.codecs_ = 0;
+        for (const auto codec : codecs.Get()) {
+            config.codecs_ |= codec;
+        }
+    }
+
+    EchoServer server(config);
+    error = server.run();
+    return error;
+}
@@ -0,0 +1,63 @@
+#include "blockpool.h"
+
+#include "cachealigned.h"
+
+namespace {
+char *alignedAlloc(const size_t size)
+{
+    return static_cast<char *>(cachealigned::alloc(size));
+}
+
+void alignedFree(char *ptr)
+{
+    cachealigned::free(ptr);
+}
+}  // namespace
+
+BlockPool::BlockPool() : blockSize_(0)
+{
+}
+
+BlockPool::~BlockPool()
+{
+    free_all();
+}
+
+void BlockPool::free_all()
+{
+    for (auto block : free_) {
+        alignedFree(block);
+    }
+    free_.clear();
+}
+
+void BlockPool::reset(const size_t blockSize)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blockSize != blockSize_) {
+        free_all();
+        blockSize_ = blockSize;
+    }
+}
+
+char *BlockPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            auto block = free_.back();
+            free_.pop_back();
+            return block;
+        }
+    }
+    return blockSize_ > 0 ? alignedAlloc(blockSize_) : nullptr;
+}
+
+void BlockPool::release(char *block)
+{
+    if (block == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(block);
+}
@@ -0,0 +1,82 @@
+/** @file blockpool.h
+ * @brief Pool of block buffers of TCPClient
+ */
+#ifndef BLOCKPOOL_H
+#define BLOCKPOOL_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class BlockPool
+ * @brief Buffers of size of TCP block aligned to cache line. The buffers are allocated on
+ * first demand and reused after release, so the streaming does not allocate memory per block.
+ * @par acquire() and release() may be called from different threads.
+ */
+class BlockPool
+{
+public:
+    /// Alignment of buffers
+    static const size_t alignment = 64;
+    BlockPool();
+    /// Destructor, frees all buffers (acquired buffers must be released before)
+    ~BlockPool();
+    /**
+     * @brief Set size of buffers, the free buffers of other size are freed
+     * @par Must not be called while buffers are acquired
+     */
+    void reset(const size_t blockSize);
+    /// Take a buffer, nullptr if memory is not allocated
+    char *acquire();
+    /// Return the buffer to the pool
+    void release(char *block);
+    size_t block_size() const
+    {
+        return blockSize_;
+    }
+
+private:
+    BlockPool(const BlockPool &) = delete;
+    BlockPool &operator=(const BlockPool &) = delete;
+    void free_all();
+
+    std::vector<char *> free_;
+    size_t blockSize_;
+    std::mutex mutex_;
+};
+
+/**
+ * @class PooledBlock
+ * @brief Buffer of BlockPool which is returned to the pool by destructor
+ */
+class PooledBlock
+{
+public:
+    explicit PooledBlock(BlockPool &pool) : pool_(pool), data_(pool.acquire()) {}
+    ~PooledBlock()
+    {
+        if (data_) {
+            pool_.release(data_);
+        }
+    }
+    char *data() const
+    {
+        return data_;
+    }
+    /// The block is viewed as 64-bit words
+    uint64_t *words() const
+    {
+        return reinterpret_cast<uint64_t *>(data_);
+    }
+
+private:
+    PooledBlock(const PooledBlock &) = delete;
+    PooledBlock &operator=(const PooledBlock &) = delete;
+
+    BlockPool &pool_;
+    char *data_;
+};
+
+#endif // BLOCKPOOL_H
@@ -0,0 +1,74 @@
+/** @file cachealigned.h
+ * @brief Memory aligned to cache line, for data which is written by different threads
+ */
+#ifndef CACHEALIGNED_H
+#define CACHEALIGNED_H
+
+#include <memory>
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace cachealigned {
+
+/// Size of cache line
+static const size_t lineSize = 64;
+
+/// Allocate memory aligned to cache line, the size is rounded up to cache lines,
+/// so the neighbour allocations do not share a line
+inline void *alloc(const size_t size)
+{
+    const size_t alignedSize = (size + lineSize - 1) / lineSize * lineSize;
+#ifdef _WIN32
+    return _aligned_malloc(alignedSize, lineSize);
+#else
+    void *ptr(nullptr);
+    if (posix_memalign(&ptr, lineSize, alignedSize) != 0) {
+        return nullptr;
+    }
+    return ptr;
+#endif
+}
+
+inline void free(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+template <typename T>
+struct Deleter {
+    void operator()(T *ptr) const
+    {
+        if (ptr) {
+            ptr->~T();
+            cachealigned::free(ptr);
+        }
+    }
+};
+
+/// Owner of object on its own cache lines (operator new of C++11 does not keep alignas(64))
+template <typename T>
+using Ptr = std::unique_ptr<T, Deleter<T>>;
+
+/// Create object by default constructor on its own cache lines
+template <typename T>
+Ptr<T> make()
+{
+    void *memory = alloc(sizeof(T));
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return Ptr<T>(new (memory) T());
+}
+
+} // namespace cachealigned
+
+#endif // CACHEALIGNED_H
@@ -0,0 +1,156 @@
+/** @file spscring.h
+ * @brief Lock-free ring of slots for one producer thread and one consumer thread
+ */
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class SpscRing
+ * @brief Bounded ring of preallocated slots, the slots are filled and taken in place.
+ * @par The producer takes a free slot by write_slot(), fills it and publishes it by push().
+ * The consumer takes the oldest published slot by read_slot() and releases it by pop().
+ * Only one thread may produce and only one thread may consume.
+ * @par The wait_*() calls spin briefly and then sleep until the other side calls push(), pop(),
+ * notify() or cancel(), the mutex is taken only if a thread sleeps.
+ * @code
+ * SpscRing<std::vector<char>> ring(8);
+ * // producer
+ * auto slot = ring.write_slot();   // nullptr if ring is full
+ * if (slot) { fill(*slot); ring.push(); }
+ * // consumer
+ * auto item = ring.read_slot();    // nullptr if ring is empty
+ * if (item) { use(*item); ring.pop(); }
+ * @endcode
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    /// Constructor, "capacity" slots are created by default constructor of T
+    explicit SpscRing(const size_t capacity)
+        : slots_(capacity > 0 ? capacity : 1), head_(0), tail_(0), waiters_(0), cancelled_(false)
+    {
+    }
+    /// Free slot for the producer, nullptr if ring is full
+    T *write_slot()
+    {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+            return nullptr;
+        }
+        return &slots_[tail % slots_.size()];
+    }
+    /// Publish the slot which is returned by write_slot()
+    void push()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        notify();
+    }
+    /// Oldest published slot for the consumer, nullptr if ring is empty
+    T *read_slot()
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots_[head % slots_.size()];
+    }
+    /// Release the slot which is returned by read_slot()
+    void pop()
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        notify();
+    }
+    /// Free slot for the producer, waits while ring is full, nullptr if ring is cancelled
+    T *wait_write_slot()
+    {
+        T *slot(nullptr);
+        wait([this, &slot]() {
+            return (slot = write_slot()) != nullptr;
+        });
+        return slot;
+    }
+    /// Oldest published slot for the consumer, waits while ring is empty, nullptr if ring is cancelled
+    T *wait_read_slot()
+    {
+        T *slot(nullptr);
+        wait([this, &slot]() {
+            return (slot = read_slot()) != nullptr;
+        });
+        return slot;
+    }
+    /**
+     * @brief Wait until "ready" returns true, it is checked again after every push(), pop() and notify()
+     * @return false if ring is cancelled
+     */
+    template <typename Pred>
+    bool wait(Pred ready)
+    {
+        for (int i = 0; i < spinCount; ++i) {
+            if (ready()) {
+                return true;
+            }
+            if (cancelled_.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1);
+        // pairs with the fence of notify(): either the waiter sees the change or notify() sees the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv_.wait(lock, [this, &ready]() {
+            return cancelled_.load(std::memory_order_relaxed) || ready();
+        });
+        waiters_.fetch_sub(1);
+        return !cancelled_.load(std::memory_order_relaxed) || ready();
+    }
+    /// Wake the sleeping thread, e.g. after the state which is waited by wait() is changed by other thread
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
+    /// Finish all waits of both sides, e.g. if the consumer fails
+    void cancel()
+    {
+        cancelled_.store(true);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_all();
+    }
+    size_t capacity() const
+    {
+        return slots_.size();
+    }
+    /// All slots, e.g. for allocation of buffers before start of threads
+    std::vector<T> &slots()
+    {
+        return slots_;
+    }
+
+private:
+    /// Checks of wait() before sleeping
+    static const int spinCount = 64;
+
+    std::vector<T> slots_;
+    /// Counters of taken and published slots, on separate cache lines
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    /// Count of threads which sleep in wait()
+    alignas(64) std::atomic<int> waiters_;
+    std::atomic<bool> cancelled_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,62 @@
+#include "tcpasync.h"
+
+#include <algorithm>
+
+AsyncQueue::AsyncQueue(const size_t depth)
+    : depth_(std::max<size_t>(1, depth))
+    , count_(0)
+    , stop_(false)
+{
+    worker_ = std::thread(&AsyncQueue::run, this);
+}
+
+AsyncQueue::~AsyncQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void AsyncQueue::post(const Task &task)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() {
+        return count_ < depth_;
+    });
+    tasks_.push_back(task);
+    ++count_;
+    cv_.notify_all();
+}
+
+void AsyncQueue::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() {
+        return 0 == count_;
+    });
+}
+
+void AsyncQueue::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this]() {
+            return !tasks_.empty() || stop_;
+        });
+        if (tasks_.empty()) {
+            break;
+        }
+        auto task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+        --count_;
+        cv_.notify_all();
+    }
+}
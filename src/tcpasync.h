@@ -0,0 +1,48 @@
+/** @file tcpasync.h
+ * @brief Queue of asynchronous operations of TCPClient
+ */
+#ifndef TCPASYNC_H
+#define TCPASYNC_H
+
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/**
+ * @class AsyncQueue
+ * @brief Runs the posted tasks one after another in one worker thread.
+ * @par Not more than "depth" tasks are queued or running, post() waits for a free place,
+ * so the caller can not run away from the socket.
+ */
+class AsyncQueue
+{
+public:
+    typedef std::function<void()> Task;
+    /**
+     * @brief Constructor, starts the worker thread
+     * @param depth - max count of queued and running tasks
+     */
+    explicit AsyncQueue(const size_t depth);
+    /// Destructor, runs all queued tasks and stops the worker thread
+    ~AsyncQueue();
+    /// Queue the task, waits if the queue is full
+    void post(const Task &task);
+    /// Wait until all posted tasks are finished
+    void wait_idle();
+
+private:
+    void run();
+
+    std::deque<Task> tasks_;
+    size_t depth_;
+    /// Count of queued and running tasks
+    size_t count_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread worker_;
+};
+
+#endif // TCPASYNC_H
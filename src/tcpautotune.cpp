@@ -0,0 +1,176 @@
+#include "tcpautotune.h"
+#include "tcpclientapp.h"
+
+#include <fstream>
+#include <iomanip>
+#include <future>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+namespace {
+/// Queue depths of every I/O engine which are probed
+const uint32_t probeQueueDepths[] = { 4, 16, 64 };
+
+std::string ioModeName(const IoMode mode)
+{
+    for (const auto &it : utils::typesOfIoMode) {
+        if (it.second == mode) {
+            return it.first;
+        }
+    }
+    return "blocking";
+}
+}  // namespace
+
+std::string AutoTune::default_cache_file()
+{
+    const char *home = std::getenv("HOME");
+    return std::string(home ? std::string(home) + "/" : "") + ".tcp_client_tune";
+}
+
+std::string AutoTune::key(const ConnectionInfo &connectionInfo)
+{
+    return connectionInfo.remoteAddress_ + ":" + std::to_string(connectionInfo.port_);
+}
+
+bool AutoTune::load(const std::string &cacheFile, const ConnectionInfo &connectionInfo, Result &result)
+{
+    std::ifstream ifs(cacheFile);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    const auto server = key(connectionInfo);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::istringstream ss(line);
+        std::string name, mode;
+        unsigned nSockets(0), duplex(0);
+        Result res;
+        if (!(ss >> name >> mode >> res.ioQueueDepth_ >> res.tcpBufSize_ >> nSockets >> duplex >> res.gbps_) || name != server) {
+            continue;
+        }
+        const auto it = utils::typesOfIoMode.find(mode);
+        if (it == utils::typesOfIoMode.end()) {
+            continue;
+        }
+        res.ioMode_ = it->second;
+        res.nSockets_ = static_cast<uint8_t>(nSockets);
+        res.isDuplexSockets_ = 0 != duplex;
+        result = res;
+        return true;
+    }
+    return false;
+}
+
+bool AutoTune::save(const std::string &cacheFile, const ConnectionInfo &connectionInfo, const Result &result)
+{
+    const auto server = key(connectionInfo);
+    std::vector<std::string> lines;
+    {
+        std::ifstream ifs(cacheFile);
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (line.compare(0, server.size() + 1, server + " ") != 0) {
+                lines.push_back(line);
+            }
+        }
+    }
+    std::ostringstream ss;
+    ss << server << " " << ioModeName(result.ioMode_) << " " << result.ioQueueDepth_ << " " << result.tcpBufSize_
+       << " " << unsigned(result.nSockets_) << " " << (result.isDuplexSockets_ ? 1 : 0) << " " << result.gbps_;
+    lines.push_back(ss.str());
+
+    std::ofstream ofs(cacheFile, std::ofstream::out | std::ofstream::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "File \"" << cacheFile << "\" not created." << std::endl;
+        return false;
+    }
+    for (const auto &line : lines) {
+        ofs << line << "\n";
+    }
+    return ofs.good();
+}
+
+void AutoTune::apply(const Result &result, ConnectionInfo &connectionInfo)
+{
+    connectionInfo.ioMode_ = result.ioMode_;
+    connectionInfo.ioQueueDepth_ = result.ioQueueDepth_;
+}
+
+double AutoTune::probe(const ConnectionInfo &connectionInfo, const uint64_t probeBytes, ConnectionInfo &serverInfo)
+{
+    TCPClient client;
+    client.initConnection(connectionInfo);
+    if (!client.connect()) {
+        return -1;
+    }
+    serverInfo = client.get_connection_info();
+    if (serverInfo.ioMode_ != connectionInfo.ioMode_) {
+        // the engine is not supported, TCPClient is fallen back to blocking I/O
+        client.disconnect();
+        return -1;
+    }
+    const size_t payload = serverInfo.tcpBufSize_ - 2 * sizeof(uint64_t);
+    std::vector<char> data(payload, 0x5A);
+    const uint64_t blocks = std::max<uint64_t>(1, probeBytes / payload);
+
+    const auto t_start = std::chrono::steady_clock::now();
+    auto f_rcv = std::async(std::launch::async, TCPClientApp::receiveToBin, std::ref(client), std::string());
+    for (uint64_t i = 0; i < blocks; ++i) {
+        if (client.send_block(&data.front(), static_cast<int>(payload)) < 0) {
+            break;
+        }
+    }
+    client.send_terminate();
+    const auto rcv_bytes = f_rcv.get();
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t_start).count();
+    const bool ok = 0 == client.get_error();
+    client.disconnect();
+    return ok && ns > 0 ? double(rcv_bytes) * 8 / double(ns) : -1;
+}
+
+bool AutoTune::tune(const ConnectionInfo &connectionInfo, const uint64_t probeBytes, Result &result)
+{
+    const IoMode modes[] = { IoMode::Blocking, IoMode::EventLoop, IoMode::IoUring, IoMode::Threaded };
+    std::ostringstream report;
+    bool found(false);
+    for (const auto mode : modes) {
+        for (const auto depth : probeQueueDepths) {
+            ConnectionInfo info(connectionInfo);
+            info.ioMode_ = mode;
+            info.ioQueueDepth_ = depth;
+            info.exit_ = false;
+            ConnectionInfo serverInfo;
+            const double gbps = probe(info, probeBytes, serverInfo);
+            if (gbps < 0) {
+                if (serverInfo.ioMode_ != mode) {
+                    // other depths of not supported engine are not probed
+                    break;
+                }
+                continue;
+            }
+            report << std::setw(10) << ioModeName(mode) << std::setw(8) << depth << std::setw(12) << gbps << "\n";
+            if (!found || gbps > result.gbps_) {
+                found = true;
+                result.ioMode_ = mode;
+                result.ioQueueDepth_ = depth;
+                result.tcpBufSize_ = serverInfo.tcpBufSize_;
+                result.nSockets_ = serverInfo.nSockets_;
+                result.isDuplexSockets_ = serverInfo.isDuplexSockets_;
+                result.gbps_ = gbps;
+            }
+        }
+    }
+    std::cout << "*********** Calibration of " << key(connectionInfo) << ": ***********\n"
+              << "   io_mode   depth      Gbit/s\n"
+              << report.str();
+    if (found) {
+        std::cout << "Selected: " << ioModeName(result.ioMode_) << ", queue depth " << result.ioQueueDepth_ << std::endl;
+    } else {
+        std::cerr << "Calibration is failed." << std::endl;
+    }
+    return found;
+}
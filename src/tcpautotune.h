@@ -0,0 +1,66 @@
+/** @file tcpautotune.h
+ * @brief Choice of I/O settings of TCPClient by short calibration transfers
+ */
+#ifndef TCPAUTOTUNE_H
+#define TCPAUTOTUNE_H
+
+#include "tcpclient.h"
+
+#include <string>
+
+/**
+ * @class AutoTune
+ * @brief Probes the I/O engines and queue depths of TCPClient against the server and keeps
+ * the fastest combination in a cache file per host:port.
+ * @par The block size, the count of sockets and the duplex mode are set by the server
+ * in the socketconfig block, so they are not probed. They are saved with the result for information,
+ * the calibration should be run again after the server is reconfigured.
+ * @par Format of cache file is one line per server:
+ * @code
+ * <host>:<port> <io_mode> <queue_depth> <block_size> <n_sockets> <duplex> <Gbit/s>
+ * @endcode
+ */
+class AutoTune
+{
+public:
+    /// Result of calibration of one server
+    struct Result {
+        IoMode ioMode_;
+        uint32_t ioQueueDepth_;
+        /// Parameters of server at time of calibration
+        uint32_t tcpBufSize_;
+        uint8_t nSockets_;
+        bool isDuplexSockets_;
+        double gbps_;
+        Result() : ioMode_(IoMode::Blocking), ioQueueDepth_(16), tcpBufSize_(0), nSockets_(0), isDuplexSockets_(false), gbps_(0) {}
+    };
+    /// Default cache file: $HOME/.tcp_client_tune (current directory if $HOME is not set)
+    static std::string default_cache_file();
+    /**
+     * @brief Read result of server connectionInfo.remoteAddress_:connectionInfo.port_ from cache file
+     * @return false if the server is not in the file
+     */
+    static bool load(const std::string &cacheFile, const ConnectionInfo &connectionInfo, Result &result);
+    /// Write result of server to cache file, the results of other servers are kept
+    static bool save(const std::string &cacheFile, const ConnectionInfo &connectionInfo, const Result &result);
+    /**
+     * @brief Run calibration transfers of "probeBytes" bytes with every I/O engine and queue depth
+     * @param connectionInfo - parameters of connection, the ioMode_ and ioQueueDepth_ are probed
+     * @param result - the fastest combination
+     * @return false if no calibration transfer is finished
+     */
+    static bool tune(const ConnectionInfo &connectionInfo, const uint64_t probeBytes, Result &result);
+    /// Set the I/O settings of result to connectionInfo
+    static void apply(const Result &result, ConnectionInfo &connectionInfo);
+
+private:
+    /**
+     * @brief One calibration transfer: the data is sent and its echo is received at the same time
+     * @param serverInfo - parameters of connection after handshake
+     * @return speed in Gbit/s, negative if error or the I/O engine is not supported
+     */
+    static double probe(const ConnectionInfo &connectionInfo, const uint64_t probeBytes, ConnectionInfo &serverInfo);
+    static std::string key(const ConnectionInfo &connectionInfo);
+};
+
+#endif // TCPAUTOTUNE_H
@@ -1,10 +1,28 @@
 #include "tcpclient.h"
+#include "tcpeventloop.h"
+#include "tcpiouring.h"
+#include "tcpthreaded.h"
+#include "tcpasync.h"
+#include "blockpool.h"
+#include "tcpzerocopy.h"
+#include "tcpscheduler.h"
+#include "tcptrace.h"
 
 #include <iomanip>
 #include <iostream>
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#ifndef _WIN32
+#include <poll.h>
+#include <fcntl.h>
+#endif
 
 
 //#define _DEBUG_INFO
@@ -42,6 +60,9 @@ bool TcpIoBlock::check(const uint64_t &ui64)
 } // namespace Version
 
 namespace {
+/// Size of header of block: size of data and type of data
+const size_t headerSize = 2 * sizeof(uint64_t);
+
 void uInt64ToChar8(uint64_t i64, void *char8buf)
 {
     memcpy(char8buf, &i64, sizeof(i64));
@@ -50,9 +71,27 @@ void char8ToUint64(void *char8buf, uint64_t &i64)
 {
     memcpy(&i64, char8buf, sizeof(i64));
 }
+/// Create engines of type Engine for the send and the receive sockets
+template <typename Engine>
+bool createEngines(const ConnectionInfo &info, const Connection &connection,
+                   std::unique_ptr<BlockTransport> &sendEngine, std::unique_ptr<BlockTransport> &rcvEngine)
+{
+    std::unique_ptr<Engine> sendE(new Engine(connection.sockfd_send_, false, info.tcpBufSize_, info.ioQueueDepth_,
+                                             info.timeOut_));
+    std::unique_ptr<Engine> rcvE(new Engine(connection.sockfd_rcv_, true, info.tcpBufSize_, info.ioQueueDepth_,
+                                            info.timeOut_));
+    if (!sendE->init() || !rcvE->init()) {
+        return false;
+    }
+    sendEngine = std::move(sendE);
+    rcvEngine = std::move(rcvE);
+    return true;
+}
 }  // namespace
 
-TCPClient::TCPClient() : bytesSent_(0), bytesReceived_(0), sentTime_(0), receivedTime_(0), lastError_(0)
+TCPClient::TCPClient() : lastError_(0),
+    codec_(CompressionCodec::Uncompressed), serverCodecs_(0), rcvNeedSocket_(0), window_(0), rcvBlockOffset_(0), rcvBlock_(nullptr),
+    blockPool_(new BlockPool())
 {
     //const uint64_t gVersion = 0x01000001;
     std::cout << "TCP client library version: " << Version::to_string(Version::TcpClientLibrary::gVersion) << std::endl;
@@ -60,6 +99,20 @@ TCPClient::TCPClient() : bytesSent_(0), bytesReceived_(0), sentTime_(0), receive
 
 TCPClient::~TCPClient()
 {
+    if (connection_.state_ == ConnectionState::Connected) {
+        // the queued async operations fail without I/O, the running ones are released by shutdown,
+        // the sockets are closed only after the queues are drained
+        shutdown_sockets();
+    }
+    wait_async();
+    // the sockets which are only shut down by an error of async operation are closed too
+    auto isOpen = std::any_of(connection_.sockfd_.begin(), connection_.sockfd_.end(), [](const DS_SOCKET & sock) {
+        return sock != 0;
+    });
+    if (isOpen) {
+        disconnect();
+    }
+    blockPool_->release(rcvBlock_);
 #ifdef _WIN32
     if (connection_.state_ == ConnectionState::Initialized) {
         WSACleanup();
@@ -72,6 +125,9 @@ std::mutex TCPClient::mutex_;
 
 void TCPClient::SleepMs(int sleepMs)
 {
+    if (sleepMs <= 0) {
+        return;
+    }
 #ifdef _WIN32
     Sleep(static_cast<uint16_t>(sleepMs));
 #else
@@ -127,8 +183,250 @@ int setSockOpt(const DS_SOCKET socket, const int optname, const int optval)
     return getSockOpt(socket, optname);
 }
 
+namespace {
+void closeSocket(const DS_SOCKET sock)
+{
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(static_cast<int>(sock));
+#endif
+}
+
+/// Switch the socket to non-blocking mode (or back to blocking mode)
+bool setNonBlocking(const DS_SOCKET sock, const bool on)
+{
+#ifdef _WIN32
+    u_long mode = on ? 1 : 0;
+    return 0 == ioctlsocket(sock, FIONBIO, &mode);
+#else
+    const int flags = fcntl(static_cast<int>(sock), F_GETFL, 0);
+    return flags >= 0 && 0 == fcntl(static_cast<int>(sock), F_SETFL, on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+}
+
+/// The non-blocking connect is started and its result is reported later
+bool isConnectInProgress(const int err)
+{
+#ifdef _WIN32
+    return err == WSAEWOULDBLOCK;
+#else
+    return err == EINPROGRESS || err == EINTR;
+#endif
+}
+}  // namespace
+
+bool TCPClient::connect_sockets(const size_t count, std::vector<DS_SOCKET> &sockets)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(std::max(0, connectionInfo_.waitConnect_));
+    int retryMs(std::max(1, connectionInfo_.connectRetryMs_));
+    int lastErr(0);
+    sockets.clear();
+    while (sockets.size() < count) {
+        // start connect of all missing sockets, the handshakes of them go at the same time
+        std::vector<struct pollfd> fds;
+        for (size_t i = sockets.size(); i < count; ++i) {
+            auto sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            set_socket_options(sock);
+            if (!setNonBlocking(sock, true)) {
+                std::cerr << GetLastError() << ": Error set non-blocking mode of socket." << std::endl;
+                closeSocket(sock);
+                break;
+            }
+            if (0 == ::connect(sock, reinterpret_cast<struct sockaddr *>(&connection_.server_addr_), sizeof(connection_.server_addr_))) {
+                setNonBlocking(sock, false);
+                sockets.push_back(sock);
+            } else if (isConnectInProgress(GetLastError())) {
+                struct pollfd fd;
+                fd.fd = sock;
+                fd.events = POLLOUT;
+                fd.revents = 0;
+                fds.push_back(fd);
+            } else {
+                lastErr = GetLastError();
+                closeSocket(sock);
+            }
+        }
+        // the connect in progress is waited not less than wait_step_sec, every socket till its own end of handshake
+        const auto pollDeadline = std::max(deadline, std::chrono::steady_clock::now() + std::chrono::seconds(wait_step_sec));
+        while (!fds.empty()) {
+            const auto waitMs =
+                std::chrono::duration_cast<std::chrono::milliseconds>(pollDeadline - std::chrono::steady_clock::now()).count();
+            int ret(0);
+            if (waitMs > 0) {
+#ifdef _WIN32
+                ret = WSAPoll(&fds[0], static_cast<ULONG>(fds.size()), static_cast<int>(waitMs));
+#else
+                ret = ::poll(&fds[0], fds.size(), static_cast<int>(waitMs));
+#endif
+                if (ret < 0 && GetLastError() == EINTR) {
+                    continue;
+                }
+            }
+            if (ret <= 0) {
+                // the deadline or the error of poll, the sockets in progress are failed
+                lastErr = ret < 0 ? GetLastError() : ETIMEDOUT;
+                for (const auto &fd : fds) {
+                    closeSocket(fd.fd);
+                }
+                fds.clear();
+                break;
+            }
+            // the finished handshakes are taken out, the others are polled again
+            std::vector<struct pollfd> pending;
+            for (auto &fd : fds) {
+                if (0 == fd.revents) {
+                    pending.push_back(fd);
+                    continue;
+                }
+                int err(-1);
+                socklen_t len(sizeof(err));
+                if (getsockopt(fd.fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&err), &len) != 0) {
+                    err = -1;
+                }
+                if (0 == err && setNonBlocking(fd.fd, false)) {
+                    sockets.push_back(fd.fd);
+                } else {
+                    lastErr = err > 0 ? err : ETIMEDOUT;
+                    closeSocket(fd.fd);
+                }
+            }
+            fds.swap(pending);
+        }
+        if (sockets.size() == count) {
+            break;
+        }
+        auto leftMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (leftMs < retryMs) {
+            for (auto sock : sockets) {
+                closeSocket(sock);
+            }
+            sockets.clear();
+#ifdef _WIN32
+            WSASetLastError(lastErr);
+#else
+            errno = lastErr;
+#endif
+            set_error("Error connecting");
+            return false;
+        }
+        std::cout << "Waiting of connect..." << (leftMs / 1000) << "s\n";
+        SleepMs(retryMs);
+        retryMs = std::min(retryMs * 2, wait_step_sec * 1000);
+    }
+    return true;
+}
+
+namespace {
+/// Set option of TCP level (IPPROTO_TCP) or socket level, the error is printed with name of option
+bool setOption(const DS_SOCKET sock, const int level, const int optname, const void *optval, const socklen_t optlen,
+               const char *name)
+{
+    if (setsockopt(sock, level, optname, static_cast<const char *>(optval), optlen) != 0) {
+        std::cerr << GetLastError() << ": Error set socket option " << name << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int getOption(const DS_SOCKET sock, const int level, const int optname)
+{
+    int optval(0);
+    socklen_t optlen(sizeof(optval));
+    if (getsockopt(sock, level, optname, reinterpret_cast<char *>(&optval), &optlen) != 0) {
+        return -1;
+    }
+    return optval;
+}
+}  // namespace
+
+void TCPClient::set_socket_options(const DS_SOCKET sock)
+{
+    const auto &opt = connectionInfo_.socketOptions_;
+    if (opt.noDelay_) {
+        const int on(1);
+        setOption(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on), "TCP_NODELAY");
+    }
+    if (opt.cork_) {
+#ifdef TCP_CORK
+        const int on(1);
+        setOption(sock, IPPROTO_TCP, TCP_CORK, &on, sizeof(on), "TCP_CORK");
+#else
+        std::cerr << "TCP_CORK is not supported." << std::endl;
+#endif
+    }
+    if (opt.notSentLowat_ > 0) {
+#ifdef TCP_NOTSENT_LOWAT
+        setOption(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &opt.notSentLowat_, sizeof(opt.notSentLowat_), "TCP_NOTSENT_LOWAT");
+#else
+        std::cerr << "TCP_NOTSENT_LOWAT is not supported." << std::endl;
+#endif
+    }
+    if (!opt.congestion_.empty()) {
+#ifdef TCP_CONGESTION
+        setOption(sock, IPPROTO_TCP, TCP_CONGESTION, opt.congestion_.c_str(), static_cast<socklen_t>(opt.congestion_.size()),
+                  "TCP_CONGESTION");
+#else
+        std::cerr << "TCP_CONGESTION is not supported." << std::endl;
+#endif
+    }
+    if (opt.busyPollUs_ > 0) {
+#ifdef SO_BUSY_POLL
+        setOption(sock, SOL_SOCKET, SO_BUSY_POLL, &opt.busyPollUs_, sizeof(opt.busyPollUs_), "SO_BUSY_POLL");
+#else
+        std::cerr << "SO_BUSY_POLL is not supported." << std::endl;
+#endif
+    }
+    // the buffers are set before connect, so the window scale of connection is chosen for them
+    const int bufSize = opt.buffer_size(connectionInfo_.nSockets_);
+    if (bufSize > 0) {
+        setOption(sock, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize), "SO_SNDBUF");
+        setOption(sock, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize), "SO_RCVBUF");
+    }
+}
+
+void TCPClient::print_socket_options(const DS_SOCKET sock)
+{
+    std::cout << "TCP_NODELAY:                       " << (getOption(sock, IPPROTO_TCP, TCP_NODELAY) > 0 ? "on" : "off") << "\n";
+#ifdef TCP_CORK
+    std::cout << "TCP_CORK:                          " << (getOption(sock, IPPROTO_TCP, TCP_CORK) > 0 ? "on" : "off") << "\n";
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+    std::cout << "TCP_NOTSENT_LOWAT:                 " << getOption(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT) << "\n";
+#endif
+#ifdef TCP_CONGESTION
+    char congestion[32] = { 0 };
+    socklen_t len(sizeof(congestion) - 1);
+    if (getsockopt(sock, IPPROTO_TCP, TCP_CONGESTION, congestion, &len) == 0) {
+        std::cout << "Congestion control:                " << congestion << "\n";
+    }
+#endif
+#ifdef SO_BUSY_POLL
+    std::cout << "SO_BUSY_POLL:                      " << getOption(sock, SOL_SOCKET, SO_BUSY_POLL) << " us\n";
+#endif
+}
+
+void TCPClient::negotiate_codec()
+{
+    codec_ = CompressionCodec::Uncompressed;
+    const auto requested = connectionInfo_.compression_;
+    if (CompressionCodec::Uncompressed == requested) {
+        return;
+    }
+    if (0 == (compression::available() & compression::bit(requested))) {
+        std::cout << "Compression " << compression::name(requested) << " is not built, the blocks are sent uncompressed" << std::endl;
+    } else if (0 == (serverCodecs_ & compression::bit(requested))) {
+        std::cout << "Compression " << compression::name(requested) << " is not supported by server, the blocks are sent uncompressed"
+                  << std::endl;
+    } else {
+        codec_ = requested;
+        std::cout << "Compression of blocks:             " << compression::name(codec_) << std::endl;
+    }
+}
+
 bool TCPClient::configSocket(const size_t &idx_socket, const DS_SOCKET &sock, size_t &socketID)
 {
+    TraceSpan span("handshake", "connect", "socket", static_cast<int64_t>(idx_socket));
     std::vector<uint64_t> buf(8);
     const int ctrl_buf_size = int(buf.size() * sizeof(uint64_t));
     char *pBuf = reinterpret_cast<char *>(&buf[0]);
@@ -189,6 +487,11 @@ bool TCPClient::configSocket(const size_t &idx_socket, const DS_SOCKET &sock, si
                 connection_.sockfd_send_.resize(connectionInfo_.nSockets_ / 2, 0);
                 connection_.sockfd_rcv_.resize(connectionInfo_.nSockets_ / 2, 0);
             }
+            // new states for the new connection, the states of last one are kept until now for statistics
+            connection_.states_.clear();
+            connection_.states_.resize(connectionInfo_.nSockets_);
+            connection_.sendStates_.assign(connection_.sockfd_send_.size(), nullptr);
+            connection_.rcvStates_.assign(connection_.sockfd_rcv_.size(), nullptr);
         }
         res = true;
     }
@@ -207,28 +510,47 @@ bool TCPClient::configSocket(const size_t &idx_socket, const DS_SOCKET &sock, si
 
         rBytes = ::recv(sock, pBuf, new_buf_size - ctrl_buf_size, MSG_WAITALL);
         res = rBytes == new_buf_size - ctrl_buf_size;
+        if (res && 0 == idx_socket) {
+            // the first word after the configuration is the mask of codecs of server, tcp_io_block sends zero
+            serverCodecs_ = rBytes >= int(sizeof(uint64_t)) ? buf[0] : 0;
+            negotiate_codec();
+        }
         if (res) {
             std::cout << "Socket number:                     " << (idx_socket + 1) << "\n"
                       << "Socket ID:                         " << sock << "\n"
                       << "Client socket send buffer size:    " << buf_size_send << "\n"
-                      << "Client socket receive buffer size: " << buf_size_receive << std::endl;
+                      << "Client socket receive buffer size: " << buf_size_receive << "\n";
+            print_socket_options(sock);
+            std::cout << std::flush;
 
             connection_.sockfd_[socketID] = sock;
+            auto state = cachealigned::make<SocketState>();
+            state->sock_ = sock;
+            state->id_ = socketID;
 
             if (connectionInfo_.isDuplexSockets_) {
                 connection_.sockfd_send_[socketID] = sock;
                 connection_.sockfd_rcv_[socketID] = sock;
+                state->isSend_ = true;
+                state->isReceive_ = true;
+                connection_.sendStates_[socketID] = state.get();
+                connection_.rcvStates_[socketID] = state.get();
                 std::cout << "Type of using socket:               " << "Out&In" << std::endl;
             } else {
                 size_t div_2 = connectionInfo_.nSockets_ / 2;
                 if (socketID < div_2) {
                     connection_.sockfd_send_[socketID] = sock;
+                    state->isSend_ = true;
+                    connection_.sendStates_[socketID] = state.get();
                     std::cout << "Type of using socket:              " << "Out" << std::endl;
                 } else {
                     connection_.sockfd_rcv_[socketID - div_2] = sock;
+                    state->isReceive_ = true;
+                    connection_.rcvStates_[socketID - div_2] = state.get();
                     std::cout << "Type of using socket:              " << "In" << std::endl;
                 }
             }
+            connection_.states_[socketID] = std::move(state);
             std::cout << std::string(40, '*') << std::endl;
         }
     }
@@ -240,66 +562,187 @@ bool TCPClient::configSocket(const size_t &idx_socket, const DS_SOCKET &sock, si
 
 bool TCPClient::connect()
 {
-    auto count_sockets(0);
+    size_t count_sockets(0);
+    std::vector<DS_SOCKET> sockets;
     do {
-        //auto &sock = connection_.sockfd_[idx];
-        auto sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-        // create a connection with the server
-        int err_connect(0);
-        int sec_left(connectionInfo_.waitConnect_);
-        std::cout << "Connecting of TCP socket " << (count_sockets + 1) << "...";
-        do {
-            err_connect = ::connect(sock, reinterpret_cast<struct sockaddr *>(&connection_.server_addr_),
-                                    sizeof(connection_.server_addr_));
-            if (err_connect < 0) {
-                if (sec_left >= wait_step_sec) {
-                    SleepMs(wait_step_sec * 1000);
-                    sec_left -= wait_step_sec;
-                    std::cout << "Waiting of connect..." << sec_left << "s\n";
-                } else {
-                    set_error("Error connecting");
-                    return false;
-                }
-            }
-        } while (err_connect < 0);
+        // the first socket tells the count of sockets, the other sockets are connected all at once,
+        // the server sends the control blocks to all of them at the same time
+        const size_t count = (0 == count_sockets || connectionInfo_.delayAfterConnect_ > 0)
+                             ? 1 : connection_.sockfd_.size() - count_sockets;
+        std::cout << "Connecting of TCP socket " << (count_sockets + 1);
+        if (count > 1) {
+            std::cout << "-" << (count_sockets + count);
+        }
+        std::cout << "...";
+        if (!connect_sockets(count, sockets)) {
+            return false;
+        }
         std::cout << "CONNECTED" << std::endl;
 
-        size_t socketID;
-        if (!configSocket(count_sockets, sock, socketID)) {
-            return false;
+        for (size_t i = 0; i < sockets.size(); ++i) {
+            size_t socketID;
+            if (!configSocket(count_sockets, sockets[i], socketID)) {
+                for (size_t j = i; j < sockets.size(); ++j) {
+                    closeSocket(sockets[j]);
+                }
+                return false;
+            }
+            ++count_sockets;
         }
 
         if (connectionInfo_.delayAfterConnect_ > 0) {
             std::cout << "Sleep " << connectionInfo_.delayAfterConnect_ << " ms" << std::endl;
             SleepMs(connectionInfo_.delayAfterConnect_);
         }
-    } while (++count_sockets < connection_.sockfd_.size());
+    } while (count_sockets < connection_.sockfd_.size());
 
     if (connectionInfo_.timeOut_ >= 0) {
         setTimeout(connectionInfo_.timeOut_);
     }
+    if (!create_transports()) {
+        return false;
+    }
+    blockPool_->release(rcvBlock_);
+    rcvBlock_ = nullptr;
+    blockPool_->reset(connectionInfo_.tcpBufSize_);
+    // receive buffers of the blocking mode, an engine has its own queues
+    rcvBuffers_.clear();
+    if (!rcvTransport_) {
+        rcvBuffers_.resize(connection_.sockfd_rcv_.size());
+        for (auto &rb : rcvBuffers_) {
+            rb.buf_.resize(static_cast<size_t>(connectionInfo_.tcpBufSize_) * std::max<uint32_t>(1, connectionInfo_.ioQueueDepth_));
+        }
+    }
+    rcvBlockOffset_ = 0;
+    window_ = connectionInfo_.windowBytes_ > 0 ? connectionInfo_.windowBytes_
+              : uint64_t(connectionInfo_.windowBlocks_) * connectionInfo_.tcpBufSize_;
+    if (window_ > 0) {
+        std::cout << "Window of sending:                 " << window_ << " bytes" << std::endl;
+    }
     connection_.state_ = ConnectionState::Connected;
     connection_.iSocketSend_ = 0;
     connection_.iSocketRcv_ = 0;
-    bytesSent_ = 0;
-    bytesReceived_ = 0;
+    sent_.reset();
+    received_.reset();
+    sendInstrument_.configure(connectionInfo_.instrumentMode_, connectionInfo_.instrumentSampleRate_);
+    rcvInstrument_.configure(connectionInfo_.instrumentMode_, connectionInfo_.instrumentSampleRate_);
 
     return true;
 }
 
-bool TCPClient::disconnect()
+bool TCPClient::create_transports()
 {
-    for (auto &sock : connection_.sockfd_) {
+    scheduler_.reset();
+    rcvTransport_.reset();
+    sendTransport_.reset();
+    if (IoMode::EventLoop == connectionInfo_.ioMode_) {
+        if (!createEngines<EventLoopTransport>(connectionInfo_, connection_, sendTransport_, rcvTransport_)) {
+            std::cerr << "Event loop is not supported, blocking I/O is used." << std::endl;
+            connectionInfo_.ioMode_ = IoMode::Blocking;
+        }
+    } else if (IoMode::IoUring == connectionInfo_.ioMode_) {
+        if (!createEngines<IoUringTransport>(connectionInfo_, connection_, sendTransport_, rcvTransport_)) {
+            std::cerr << "io_uring is not supported, blocking I/O is used." << std::endl;
+            connectionInfo_.ioMode_ = IoMode::Blocking;
+        }
+    } else if (IoMode::Threaded == connectionInfo_.ioMode_) {
+        if (!createEngines<ThreadedTransport>(connectionInfo_, connection_, sendTransport_, rcvTransport_)) {
+            std::cerr << "Socket threads are not started, blocking I/O is used." << std::endl;
+            connectionInfo_.ioMode_ = IoMode::Blocking;
+        }
+    }
+    std::cout << "I/O mode:                          " << (sendTransport_ ? sendTransport_->name() : "blocking") << std::endl;
+
+    zeroCopySender_.reset();
+    if (connectionInfo_.zeroCopy_) {
+        if (sendTransport_) {
+            std::cerr << "Zero-copy send is supported only by blocking I/O, data is copied." << std::endl;
+        } else {
+            zeroCopySender_.reset(new ZeroCopySender(connection_.sockfd_send_, connectionInfo_.timeOut_));
+            if (!zeroCopySender_->init()) {
+                std::cerr << "Zero-copy send is not supported, data is copied." << std::endl;
+                zeroCopySender_.reset();
+            }
+        }
+        std::cout << "Zero-copy send:                    " << (zeroCopySender_ ? "on" : "off") << std::endl;
+    }
+
+    scheduler_.reset(SendScheduler::create(connectionInfo_.scheduler_, connection_.sockfd_send_, sendTransport_.get()));
+    std::cout << "Scheduler of sockets:              " << (scheduler_ ? scheduler_->name() : "round-robin") << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(laneLogMutex_);
+        laneLog_.clear();
+    }
+    return true;
+}
+
+bool TCPClient::flush()
+{
+    if (sendQueue_) {
+        sendQueue_->wait_idle();
+    }
+    if (get_error() != 0) {
+        return false;
+    }
+    TraceSpan span("flush", "net");
+    const auto t1 = sendInstrument_.start();
+    bool res = !sendTransport_ || sendTransport_->flush();
+#ifdef TCP_CORK
+    if (res && connectionInfo_.socketOptions_.cork_) {
+        // the tail which is less than segment is pushed by switching of cork off and on
+        const int off(0), on(1);
+        for (auto sock : connection_.sockfd_send_) {
+            setsockopt(sock, IPPROTO_TCP, TCP_CORK, &off, sizeof(off));
+            setsockopt(sock, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+        }
+    }
+#endif
+    // the zero-copy completions come after the corked tail is sent
+    res = res && (!zeroCopySender_ || zeroCopySender_->flush());
+    sent_.add_time(sendInstrument_.estimate(sendInstrument_.elapsed(t1)));
+    if (!res) {
+        set_error("Error write to socket");
+    }
+    return res;
+}
 
+void TCPClient::shutdown_sockets()
+{
+    {
+        // the receiver which waits for the log of sockets is released
+        std::lock_guard<std::mutex> lock(laneLogMutex_);
+        connection_.state_ = ConnectionState::Disconnected;
+    }
+    laneLogCv_.notify_all();
+    for (const auto sock : connection_.sockfd_) {
+        if (0 == sock) {
+            continue;
+        }
+        // shutdown releases the socket threads which wait in send/recv
 #ifdef _WIN32
         shutdown(sock, SD_BOTH);
+#else
+        shutdown(static_cast<int>(sock), SHUT_RDWR);
+#endif
+    }
+}
+
+bool TCPClient::disconnect()
+{
+    shutdown_sockets();
+    for (auto &sock : connection_.sockfd_) {
+        if (0 == sock) {
+            continue;
+        }
+#ifdef _WIN32
         closesocket(sock);
 #else
         close(sock);
 #endif
         sock = 0;
     }
-    connection_.state_ = ConnectionState::Disconnected;
+    // the kernel does not send the pinned data any more, the buffers are released
+    zeroCopySender_.reset();
     return true;
 }
 
@@ -310,16 +753,17 @@ ConnectionState TCPClient::getState() const
 
 int TCPClient::send_terminate()
 {
+    // the tags must follow the asynchronous blocks
+    if (sendQueue_) {
+        sendQueue_->wait_idle();
+    }
     if (get_connection_info().exit_) {
         return send_terminate_exit();
     }
-    std::vector<uint64_t> data(connectionInfo_.tcpBufSize_ / 8, 0);
-    data[0] = 8;
-    data[1] = DataTypes::service;
-    data[2] = ControlTags::terminate;
-    int bytes(0);
-    for (auto sock : connection_.sockfd_send_) {
-        bytes += send(reinterpret_cast<char *>(&data[0]), int(data.size()) * 8);
+    const uint64_t tags[] = { ControlTags::terminate };
+    int bytes = send_service_tags(tags, 1);
+    if (!flush()) {
+        return -1;
     }
     if (connection_.sockfd_send_.size() * connectionInfo_.tcpBufSize_ == bytes) {
         std::cout << "The terminate command is sent." << std::endl;
@@ -329,14 +773,13 @@ int TCPClient::send_terminate()
 
 int TCPClient::send_terminate_exit()
 {
-    std::vector<uint64_t> data(connectionInfo_.tcpBufSize_ / 8, 0);
-    data[0] = 2 * 8;
-    data[1] = DataTypes::service;
-    data[2] = ControlTags::exit;
-    data[3] = ControlTags::terminate;
-    int bytes(0);
-    for (auto sock : connection_.sockfd_send_) {
-        bytes += send(reinterpret_cast<char *>(&data[0]), int(data.size()) * 8);
+    if (sendQueue_) {
+        sendQueue_->wait_idle();
+    }
+    const uint64_t tags[] = { ControlTags::exit, ControlTags::terminate };
+    int bytes = send_service_tags(tags, 2);
+    if (!flush()) {
+        return -1;
     }
     if (connection_.sockfd_send_.size() * connectionInfo_.tcpBufSize_ == bytes) {
         std::cout << "The terminate and exit commands is sent." << std::endl;
@@ -349,29 +792,15 @@ int TCPClient::send_to_tcp_io(const char *dataIn, const int length)
     if (dataIn == nullptr) {
         return 0;
     }
-    auto bufSize = get_connection_info().tcpBufSize_;
-    auto bufDataSize(bufSize - 16);
-    std::vector<uint64_t> data(static_cast<size_t>(bufSize / 8));
-    auto pBlock = reinterpret_cast<char *>(&data[0]);
-    auto pData = reinterpret_cast<char *>(&data[2]);
-    size_t readBytes(0);
-    auto dataSize(bufDataSize);
-    data[0] = static_cast<uint64_t>(dataSize);
-    data[1] = DataTypes::data;
-    auto needReadBytes(length);
+    const int bufDataSize(static_cast<int>(get_connection_info().tcpBufSize_) - 16);
+    int readBytes(0);
     do {
-        if (bufDataSize > static_cast<uint32_t>(needReadBytes)) {
-            dataSize = needReadBytes;
-            data[0] = dataSize;
-        }
-        memcpy(pData, dataIn + readBytes, dataSize);
-        int bytesSent = send(pBlock, static_cast<int>(bufSize));
-        if (bytesSent < 0) {
+        const auto dataSize = std::min(bufDataSize, length - readBytes);
+        if (send_block(dataIn + readBytes, dataSize) < 0) {
             return -1;
         }
         readBytes += dataSize;
-        needReadBytes = length - int(readBytes);
-    } while (needReadBytes > 0);
+    } while (readBytes < length);
 
     return length;
 }
@@ -386,41 +815,437 @@ int TCPClient::send_sync(const std::vector<char> &data)
 }
 
 int TCPClient::send(const char *data, const int length)
+{
+    if (data == nullptr) {
+        return get_error() != 0 ? -2 : 0;
+    }
+    const DataPart part = { data, static_cast<size_t>(length) };
+    return send_parts(&part, 1);
+}
+
+int TCPClient::send_block(const char *data, const int length, const uint64_t dataType)
+{
+    const auto bufSize = connectionInfo_.tcpBufSize_;
+    if ((data == nullptr && length > 0) || length < 0 || static_cast<uint32_t>(length) + 16 > bufSize) {
+        std::cerr << "TCPClient::send_block: Wrong input parameters." << std::endl;
+        return -1;
+    }
+    // the block is framed by the parts of gather send, the span covers its sending
+    TraceSpan span("block", "frame", "bytes", length);
+    const uint64_t header[2] = { static_cast<uint64_t>(length), dataType };
+    const DataPart parts[3] = {
+        { reinterpret_cast<const char *>(header), sizeof(header) },
+        { data, static_cast<size_t>(length) },
+        // padding up to size of block, data_ == nullptr means zero bytes
+        { nullptr, bufSize - sizeof(header) - static_cast<size_t>(length) }
+    };
+    return send_parts(parts, 3);
+}
+
+int TCPClient::send_service_tags(const uint64_t *tags, const size_t count)
+{
+    const size_t bufSize = connectionInfo_.tcpBufSize_;
+    const uint64_t header[2] = { static_cast<uint64_t>(count * sizeof(uint64_t)), DataTypes::service };
+    const DataPart parts[3] = {
+        { reinterpret_cast<const char *>(header), sizeof(header) },
+        { reinterpret_cast<const char *>(tags), count * sizeof(uint64_t) },
+        { nullptr, bufSize - sizeof(header) - count * sizeof(uint64_t) }
+    };
+    // every socket gets the tags, the round-robin position is not changed
+    int bytes(0);
+    for (size_t i = 0; i < connection_.sockfd_send_.size(); ++i) {
+        const size_t idxSocket = scheduler_ ? i : (connection_.iSocketSend_ + i) % connection_.sockfd_send_.size();
+        if (scheduler_) {
+            log_send_socket(idxSocket);
+        }
+        auto sent = send_parts(parts, 3, idxSocket);
+        if (sent < 0) {
+            return sent;
+        }
+        bytes += sent;
+    }
+    return bytes;
+}
+
+int TCPClient::send_zc(const char *data, const int length, const SendCompletion &done)
+{
+    if (!zeroCopySender_ || length < static_cast<int>(connectionInfo_.zeroCopyMinSize_)) {
+        auto bytes = send(data, length);
+        if (done) {
+            done();
+        }
+        return bytes;
+    }
+    if (data == nullptr || get_error() != 0) {
+        return -2;
+    }
+    if (!wait_window(static_cast<size_t>(length))) {
+        return -1;
+    }
+    auto idxSocket(next_send_socket());
+    TraceSpan span("send", "net", "lane", static_cast<int64_t>(idxSocket));
+    const auto t1 = sendInstrument_.start();
+    auto bytes = zeroCopySender_->send(idxSocket, data, length, done);
+    const auto ns = sendInstrument_.elapsed(t1);
+    sent_.add_time(sendInstrument_.estimate(ns));
+    count_socket(true, idxSocket, bytes, ns);
+    if (bytes < 0) {
+        set_error("Error write to socket");
+        return -1;
+    }
+    sent_.add(static_cast<uint64_t>(bytes));
+    if (scheduler_) {
+        scheduler_->sent(idxSocket, static_cast<size_t>(bytes));
+    }
+    if (connectionInfo_.displayRaw_) {
+        display_data(data, static_cast<size_t>(length), "Send buffer to socket #" +
+                     std::to_string(idxSocket + 1) +
+                     " ID: " + std::to_string(connection_.sockfd_send_[idxSocket]));
+    }
+    SleepMs(connectionInfo_.delaySendMs_);
+    return bytes;
+}
+
+bool TCPClient::poll_send_completions(const bool wait)
+{
+    if (!zeroCopySender_) {
+        return get_error() == 0;
+    }
+    if (!zeroCopySender_->poll(wait)) {
+        set_error("Error of zero-copy sending");
+        return false;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+int TCPClient::send_file(const int fd, const int64_t offset, const int length)
 {
     if (get_error() != 0) {
         return -2;
     }
-    if (data == nullptr) {
-        return 0;
+    bool isRead(true);
+#ifdef __linux__
+    isRead = sendTransport_ || connectionInfo_.displayRaw_;
+#endif
+    if (isRead) {
+        fileBuf_.resize(static_cast<size_t>(length));
+        size_t readBytes(0);
+        while (readBytes < static_cast<size_t>(length)) {
+            auto bytes = ::pread(fd, &fileBuf_[readBytes], static_cast<size_t>(length) - readBytes,
+                                 static_cast<off_t>(offset) + static_cast<off_t>(readBytes));
+            if (bytes < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytes <= 0) {
+                std::cerr << errno << ": Error read of file." << std::endl;
+                return -1;
+            }
+            readBytes += static_cast<size_t>(bytes);
+        }
+        return send(&fileBuf_.front(), length);
     }
+#ifdef __linux__
+    if (!wait_window(static_cast<size_t>(length))) {
+        return -1;
+    }
+    auto idxSocket(next_send_socket());
+    auto off = static_cast<off_t>(offset);
+    size_t bytesSent(0);
+    TraceSpan span("sendfile", "net", "lane", static_cast<int64_t>(idxSocket));
+    const auto t1 = sendInstrument_.start();
+    while (bytesSent < static_cast<size_t>(length)) {
+        auto bytes = ::sendfile(static_cast<int>(connection_.sockfd_send_[idxSocket]), fd, &off,
+                                static_cast<size_t>(length) - bytesSent);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            // 0 - end of file before end of block
+            count_socket(true, idxSocket, -1);
+            set_error("Error write file to socket");
+            return -1;
+        }
+        bytesSent += static_cast<size_t>(bytes);
+    }
+    const auto ns = sendInstrument_.elapsed(t1);
+    sent_.add_time(sendInstrument_.estimate(ns));
+    sent_.add(bytesSent);
+    count_socket(true, idxSocket, static_cast<int64_t>(bytesSent), ns);
+    if (scheduler_) {
+        scheduler_->sent(idxSocket, bytesSent);
+    }
+    SleepMs(connectionInfo_.delaySendMs_);
+    return static_cast<int>(bytesSent);
+#else
+    return -1;
+#endif
+}
+#endif
+
+void TCPClient::send_async(const char *data, const int length, const AsyncCompletion &done)
+{
+    if (!sendQueue_) {
+        sendQueue_.reset(new AsyncQueue(connectionInfo_.asyncDepth_));
+    }
+    sendQueue_->post([this, data, length, done]() {
+        // the queued operations of closed connection are failed without I/O
+        auto bytes = connection_.state_ == ConnectionState::Connected ? send(data, length) : -1;
+        if (done) {
+            done(bytes);
+        }
+    });
+}
+
+std::future<int> TCPClient::send_async(const char *data, const int length)
+{
+    auto promise = std::make_shared<std::promise<int>>();
+    auto result = promise->get_future();
+    send_async(data, length, [promise](int bytes) {
+        promise->set_value(bytes);
+    });
+    return result;
+}
+
+void TCPClient::receive_async(char *data, const int length, const AsyncCompletion &done)
+{
+    if (!rcvQueue_) {
+        rcvQueue_.reset(new AsyncQueue(connectionInfo_.asyncDepth_));
+    }
+    rcvQueue_->post([this, data, length, done]() {
+        auto bytes = connection_.state_ == ConnectionState::Connected ? receive(data, length) : -1;
+        if (done) {
+            done(bytes);
+        }
+    });
+}
+
+std::future<int> TCPClient::receive_async(char *data, const int length)
+{
+    auto promise = std::make_shared<std::promise<int>>();
+    auto result = promise->get_future();
+    receive_async(data, length, [promise](int bytes) {
+        promise->set_value(bytes);
+    });
+    return result;
+}
+
+void TCPClient::wait_async()
+{
+    if (sendQueue_) {
+        sendQueue_->wait_idle();
+    }
+    if (rcvQueue_) {
+        rcvQueue_->wait_idle();
+    }
+}
 
+size_t TCPClient::next_send_socket()
+{
+    if (scheduler_) {
+        auto idxSocket = scheduler_->next();
+        log_send_socket(idxSocket);
+        return idxSocket;
+    }
     auto idxSocket(connection_.iSocketSend_++);
     if (connection_.iSocketSend_ == connection_.sockfd_send_.size()) {
         connection_.iSocketSend_ = 0;
     }
-    auto bytesSent(0);
-    while (bytesSent < length) {
-        auto t1 = std::chrono::high_resolution_clock::now();
-        auto bytes = ::send(connection_.sockfd_send_[idxSocket], data + bytesSent, length - bytesSent, 0);
-        sentTime_ += std::chrono::duration<uint64_t, std::nano>(std::chrono::high_resolution_clock::now() - t1).count();
-        //auto t2 = std::chrono::high_resolution_clock::now();
-        //sentTime_ += t2 - t1;
+    return idxSocket;
+}
 
+void TCPClient::log_send_socket(const size_t idxSocket)
+{
+    {
+        std::lock_guard<std::mutex> lock(laneLogMutex_);
+        laneLog_.push_back(static_cast<uint32_t>(idxSocket));
+    }
+    laneLogCv_.notify_one();
+}
+
+size_t TCPClient::next_rcv_socket()
+{
+    if (!scheduler_) {
+        auto idxSocket(connection_.iSocketRcv_++);
+        if (connection_.iSocketRcv_ == connection_.sockfd_rcv_.size()) {
+            connection_.iSocketRcv_ = 0;
+        }
+        return idxSocket;
+    }
+    // the server sends the block back to the receive socket which is paired with the send socket,
+    // the receiving may run ahead of the sending in other thread
+    std::unique_lock<std::mutex> lock(laneLogMutex_);
+    laneLogCv_.wait(lock, [this]() {
+        return !laneLog_.empty() || connection_.state_ != ConnectionState::Connected;
+    });
+    if (laneLog_.empty()) {
+        // the connection is closed, the read fails on the closed socket
+        return 0;
+    }
+    auto idxSocket = static_cast<size_t>(laneLog_.front());
+    laneLog_.pop_front();
+    return idxSocket;
+}
+
+int TCPClient::send_parts(const DataPart *parts, const size_t count)
+{
+    if (get_error() != 0) {
+        return -2;
+    }
+    size_t length(0);
+    for (size_t i = 0; i < count; ++i) {
+        length += parts[i].length_;
+    }
+    if (!wait_window(length)) {
+        return -1;
+    }
+    return send_parts(parts, count, next_send_socket());
+}
+
+bool TCPClient::wait_window(const size_t length)
+{
+    if (0 == window_) {
+        return true;
+    }
+    const auto t_start = std::chrono::steady_clock::now();
+    const uint64_t tWait = Tracer::enabled() ? instrument::ticks() : 0;
+    for (size_t spins = 0; ; ++spins) {
+        // only this thread increases sent_.bytes_, so the count of bytes in flight does not grow while waiting
+        const auto inFlight = sent_.bytes_.load(std::memory_order_relaxed) - received_.bytes_.load(std::memory_order_acquire);
+        if (0 == inFlight || inFlight + length <= window_) {
+            if (spins > 0 && tWait != 0) {
+                Tracer::record("window wait", "net", tWait, instrument::ticks(), nullptr, 0);
+            }
+            return true;
+        }
+        if (get_error() != 0 || connection_.state_ != ConnectionState::Connected) {
+            return false;
+        }
+        // the engine may hold the blocks to send them in batch, they are pushed before waiting for their echo
+        if (0 == spins && sendTransport_ && !sendTransport_->flush()) {
+            set_error("Error write to socket");
+            return false;
+        }
+        if (spins < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        if (connectionInfo_.timeOut_ > 0 && std::chrono::steady_clock::now() - t_start > std::chrono::seconds(connectionInfo_.timeOut_)) {
+            errno = ETIMEDOUT;
+            set_error("Time out of window of sending (the data is not received back)");
+            return false;
+        }
+    }
+}
+
+int TCPClient::send_parts(const DataPart *parts, const size_t count, const size_t idxSocket)
+{
+    if (get_error() != 0) {
+        return -2;
+    }
+    size_t length(0);
+    for (size_t i = 0; i < count; ++i) {
+        length += parts[i].length_;
+    }
+
+    // the block is timed once, not every call of socket
+    TraceSpan span(sendTransport_ ? "queue" : "send", "net", "lane", static_cast<int64_t>(idxSocket));
+    const auto tSend = sendInstrument_.start();
+    size_t bytesSent(0);
+    if (sendTransport_) {
+        auto bytes = sendTransport_->sendv(idxSocket, parts, count);
         if (bytes < 0) {
+            count_socket(true, idxSocket, -1);
             set_error("Error write to socket");
             return -1;
-        } else {
-            bytesSent += bytes;
         }
+        bytesSent = static_cast<size_t>(bytes);
+    } else {
+#ifdef _WIN32
+        // no gather send, the parts are staged to one buffer
+        stagingBuf_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (parts[i].data_) {
+                stagingBuf_.insert(stagingBuf_.end(), parts[i].data_, parts[i].data_ + parts[i].length_);
+            } else {
+                stagingBuf_.insert(stagingBuf_.end(), parts[i].length_, '\0');
+            }
+        }
+        while (bytesSent < length) {
+            auto bytes = ::send(connection_.sockfd_send_[idxSocket], &stagingBuf_[bytesSent], int(length - bytesSent), 0);
+            if (bytes < 0) {
+                count_socket(true, idxSocket, -1);
+                set_error("Error write to socket");
+                return -1;
+            }
+            bytesSent += static_cast<size_t>(bytes);
+        }
+#else
+        struct iovec iov[4];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        for (size_t i = 0; i < count && i < 4; ++i) {
+            if (0 == parts[i].length_) {
+                continue;
+            }
+            if (parts[i].data_) {
+                iov[msg.msg_iovlen].iov_base = const_cast<char *>(parts[i].data_);
+            } else {
+                if (zeroPad_.size() < parts[i].length_) {
+                    zeroPad_.resize(parts[i].length_, '\0');
+                }
+                iov[msg.msg_iovlen].iov_base = &zeroPad_[0];
+            }
+            iov[msg.msg_iovlen].iov_len = parts[i].length_;
+            ++msg.msg_iovlen;
+        }
+        while (bytesSent < length) {
+            auto bytes = ::sendmsg(static_cast<int>(connection_.sockfd_send_[idxSocket]), &msg, 0);
+            if (bytes < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                count_socket(true, idxSocket, -1);
+                set_error("Error write to socket");
+                return -1;
+            }
+            bytesSent += static_cast<size_t>(bytes);
+            // skip the written parts
+            auto skip = static_cast<size_t>(bytes);
+            while (skip > 0 && msg.msg_iovlen > 0) {
+                if (skip >= msg.msg_iov->iov_len) {
+                    skip -= msg.msg_iov->iov_len;
+                    ++msg.msg_iov;
+                    --msg.msg_iovlen;
+                } else {
+                    msg.msg_iov->iov_base = static_cast<char *>(msg.msg_iov->iov_base) + skip;
+                    msg.msg_iov->iov_len -= skip;
+                    skip = 0;
+                }
+            }
+        }
+#endif
+    }
+    sent_.add(bytesSent);
+    const auto ns = sendInstrument_.elapsed(tSend);
+    sent_.add_time(sendInstrument_.estimate(ns));
+    count_socket(true, idxSocket, static_cast<int64_t>(bytesSent), ns);
+    if (scheduler_) {
+        scheduler_->sent(idxSocket, bytesSent);
     }
-    bytesSent_ += bytesSent;
     if (connectionInfo_.displayRaw_) {
-        display_data(data, bytesSent, "Send buffer to socket #" +
+        std::string buf;
+        for (size_t i = 0; i < count; ++i) {
+            buf += parts[i].data_ ? std::string(parts[i].data_, parts[i].length_) : std::string(parts[i].length_, '\0');
+        }
+        display_data(buf.data(), buf.size(), "Send buffer to socket #" +
                      std::to_string(idxSocket + 1) +
                      " ID: " + std::to_string(connection_.sockfd_send_[idxSocket]));
     }
     SleepMs(connectionInfo_.delaySendMs_);
-    return bytesSent;
+    return static_cast<int>(bytesSent);
 }
 
 int TCPClient::send_need(char *data, int length)
@@ -476,74 +1301,210 @@ void TCPClient::set_display(const bool displayRaw)
 
 int TCPClient::receive_from_socket(const DS_SOCKET &socket, char *data, const int length)
 {
-    int bytes = ::recv(socket, data, length, MSG_WAITALL);
-    if (bytes < length) {
+    auto lane = std::find(connection_.sockfd_rcv_.begin(), connection_.sockfd_rcv_.end(), socket);
+    auto idxSocket = size_t(lane - connection_.sockfd_rcv_.begin());
+    if (idxSocket >= connection_.sockfd_rcv_.size() || length < 0 || read_socket(idxSocket, data, size_t(length)) < 0) {
         set_error("Error read from socket");
         return -1;
-    } else {
-        bytesReceived_ += bytes;
-        if (connectionInfo_.displayRaw_) {
-            display_data(data, bytes, "Received buffer from socket #" + std::to_string(connection_.iSocketRcv_) + " ID: " + std::to_string(
-                             socket));
-        }
     }
-    return bytes;
+    received_.add(length);
+    if (connectionInfo_.displayRaw_) {
+        display_data(data, length, "Received buffer from socket #" + std::to_string(connection_.iSocketRcv_) + " ID: " + std::to_string(
+                         socket));
+    }
+    return length;
 }
 
-int TCPClient::receive_data(char *data, int length, bool &is_terminate)
+int TCPClient::fill_rcv_buffer(const size_t idxSocket, const size_t need, uint64_t *tHeader)
 {
-    if (get_error() != 0) {
-        return -2;
+    auto &rb = rcvBuffers_[idxSocket];
+    if (0 == rb.size_) {
+        rb.head_ = 0;
+    } else if (rb.head_ + need > rb.buf_.size()) {
+        // the tail of buffer is too short for the needed data
+        memmove(&rb.buf_[0], &rb.buf_[rb.head_], rb.size_);
+        rb.head_ = 0;
     }
-    if (data == nullptr || length < static_cast<int>(connectionInfo_.tcpBufSize_)) {
-        std::cerr << "TCPClient::receive: Wrong input parameters." << std::endl;
-        return -1;
+    while (rb.size_ < need) {
+        // everything what is available, it can be several blocks
+        auto free = rb.buf_.size() - rb.head_ - rb.size_;
+        auto bytes = ::recv(connection_.sockfd_rcv_[idxSocket], &rb.buf_[rb.head_ + rb.size_], static_cast<int>(free), 0);
+        if (bytes <= 0) {
+            if (bytes < 0 && errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        const bool noHeader = rb.size_ < headerSize;
+        rb.size_ += static_cast<size_t>(bytes);
+        if (tHeader && *tHeader != 0 && noHeader && rb.size_ >= headerSize) {
+            *tHeader = instrument::ticks();
+        }
+    }
+    return static_cast<int>(rb.size_);
+}
+
+int TCPClient::read_socket(const size_t idxSocket, char *data, const size_t length)
+{
+    TraceSpan span("recv", "net", "lane", static_cast<int64_t>(idxSocket));
+    const auto t1 = rcvInstrument_.start();
+    uint64_t tHeader(t1);
+    auto bytes = rcvTransport_ ? rcvTransport_->receive(idxSocket, data, static_cast<int>(length))
+                 : read_buffered(idxSocket, data, length, &tHeader);
+    const auto ns = rcvInstrument_.elapsed(t1);
+    // the wait of first data is not time of network
+    if (received_.bytes_.load(std::memory_order_relaxed) > 0) {
+        received_.add_time(rcvInstrument_.estimate(ns));
     }
-    auto idxSocketRcv(connection_.iSocketRcv_++);
-    if (connection_.iSocketRcv_ == connection_.sockfd_rcv_.size()) {
-        connection_.iSocketRcv_ = 0;
+    count_socket(false, idxSocket, bytes, ns);
+    if (!rcvTransport_ && bytes >= 0 && length == connectionInfo_.tcpBufSize_) {
+        count_gap(idxSocket, tHeader);
     }
-    DS_SOCKET &sock = connection_.sockfd_rcv_[idxSocketRcv];
+    return bytes;
+}
 
-    std::vector<uint64_t> tmpBuf(connectionInfo_.tcpBufSize_ / 8, 0);
-    char *pTmpBuf = reinterpret_cast<char *>(&tmpBuf[0]);
-    int bytesOfData(0);
-    int bytes(0);
+void TCPClient::count_gap(const size_t idxSocket, const uint64_t tHeader)
+{
+    if (0 == tHeader || idxSocket >= connection_.rcvStates_.size() || connection_.rcvStates_[idxSocket] == nullptr) {
+        return;
+    }
+    connection_.rcvStates_[idxSocket]->gapLatency_.record(rcvInstrument_.elapsed(tHeader));
+}
 
-    is_terminate = false;
+void TCPClient::count_socket(const bool isSend, const size_t idxSocket, const int64_t result, const uint64_t ns)
+{
+    const auto &states = isSend ? connection_.sendStates_ : connection_.rcvStates_;
+    if (idxSocket >= states.size() || states[idxSocket] == nullptr) {
+        return;
+    }
+    auto &counters = isSend ? states[idxSocket]->sent_ : states[idxSocket]->received_;
+    if (result < 0) {
+        const int err = GetLastError();
+        counters.error_.store(err != 0 ? err : -1, std::memory_order_relaxed);
+        return;
+    }
+    counters.add(static_cast<uint64_t>(result));
+    counters.add_time(ns);
+    if (ns > 0) {
+        (isSend ? states[idxSocket]->sendLatency_ : states[idxSocket]->rcvLatency_).record(ns);
+    }
+}
 
-    for (;;) {
-        // receiving header
-        bytes = receive_from_socket(sock, pTmpBuf, 16);
-        if (get_error() != 0) {
-            break;
+int TCPClient::read_buffered(const size_t idxSocket, char *data, const size_t length, uint64_t *tHeader)
+{
+    auto &rb = rcvBuffers_[idxSocket];
+    size_t bytesRcv(std::min(length, rb.size_));
+    memcpy(data, &rb.buf_[rb.head_], bytesRcv);
+    rb.head_ += bytesRcv;
+    rb.size_ -= bytesRcv;
+    if (length - bytesRcv >= rb.buf_.size()) {
+        // the buffer is empty and the rest is not less than the buffer, it is read directly
+        if (tHeader && bytesRcv < headerSize) {
+            // the arrival of header is not seen by MSG_WAITALL
+            *tHeader = 0;
         }
-        // receiving data
-        if (DataTypes::data == tmpBuf[1]) {
-            bytes = receive_from_socket(sock, data, static_cast<int>(tmpBuf[0]));
-            if (get_error() != 0) {
-                break;
-            }
-            bytesOfData += bytes;
-            // receiving of align (garbage)
-            bytes = receive_from_socket(sock, pTmpBuf + 16, static_cast<int>(connectionInfo_.tcpBufSize_ - 16 - bytes));
-            if (get_error() != 0) {
-                break;
+        while (bytesRcv < length) {
+            auto bytes = ::recv(connection_.sockfd_rcv_[idxSocket], data + bytesRcv, static_cast<int>(length - bytesRcv),
+                                MSG_WAITALL);
+            if (bytes <= 0) {
+                if (bytes < 0 && errno == EINTR) {
+                    continue;
+                }
+                return -1;
             }
-        } else {
-            bytes = receive_from_socket(sock, pTmpBuf + 16, static_cast<int>(connectionInfo_.tcpBufSize_ - 16));
-            if (get_error() != 0) {
-                break;
+            bytesRcv += static_cast<size_t>(bytes);
+        }
+    } else if (bytesRcv < length) {
+        // the buffered bytes are counted from the start of block only if the buffer was empty
+        if (fill_rcv_buffer(idxSocket, length - bytesRcv, 0 == bytesRcv ? tHeader : nullptr) < 0) {
+            return -1;
+        }
+        memcpy(data + bytesRcv, &rb.buf_[rb.head_], length - bytesRcv);
+        rb.head_ += length - bytesRcv;
+        rb.size_ -= length - bytesRcv;
+    }
+    return static_cast<int>(length);
+}
+
+const char *TCPClient::receive_block(const size_t idxSocket)
+{
+    const auto bufSize = connectionInfo_.tcpBufSize_;
+    if (rcvTransport_) {
+        if (rcvBlock_ == nullptr) {
+            rcvBlock_ = blockPool_->acquire();
+            if (rcvBlock_ == nullptr) {
+                return nullptr;
             }
-            is_terminate = DataTypes::service == tmpBuf[1] && (ControlTags::terminate == tmpBuf[2] || ControlTags::terminate == tmpBuf[3]);
         }
-        break;
+        return read_socket(idxSocket, rcvBlock_, bufSize) < 0 ? nullptr : rcvBlock_;
+    }
+    // the block is parsed in place in the receive buffer
+    TraceSpan span("recv", "net", "lane", static_cast<int64_t>(idxSocket));
+    const auto t1 = rcvInstrument_.start();
+    uint64_t tHeader(t1);
+    if (fill_rcv_buffer(idxSocket, bufSize, &tHeader) < 0) {
+        count_socket(false, idxSocket, -1);
+        return nullptr;
+    }
+    const auto ns = rcvInstrument_.elapsed(t1);
+    if (received_.bytes_.load(std::memory_order_relaxed) > 0) {
+        received_.add_time(rcvInstrument_.estimate(ns));
     }
+    count_socket(false, idxSocket, bufSize, ns);
+    count_gap(idxSocket, tHeader);
+    auto &rb = rcvBuffers_[idxSocket];
+    auto pBlock = &rb.buf_[rb.head_];
+    rb.head_ += bufSize;
+    rb.size_ -= bufSize;
+    return pBlock;
+}
 
+int TCPClient::receive_data(char *data, int length, bool &is_terminate)
+{
     if (get_error() != 0) {
-        //set_error("Error read from socket");
+        return -2;
+    }
+    if (data == nullptr || length < static_cast<int>(connectionInfo_.tcpBufSize_)) {
+        std::cerr << "TCPClient::receive: Wrong input parameters." << std::endl;
+        return -1;
+    }
+    auto idxSocketRcv(next_rcv_socket());
+    is_terminate = false;
+
+    auto pBlock = receive_block(idxSocketRcv);
+    if (pBlock == nullptr) {
+        set_error("Error read from socket");
         return -1;
     }
+    received_.add(connectionInfo_.tcpBufSize_);
+    if (connectionInfo_.displayRaw_) {
+        display_data(pBlock, connectionInfo_.tcpBufSize_, "Received buffer from socket #" +
+                     std::to_string(idxSocketRcv + 1) +
+                     " ID: " + std::to_string(connection_.sockfd_rcv_[idxSocketRcv]));
+    }
+    uint64_t header[4];
+    memcpy(header, pBlock, std::min<size_t>(sizeof(header), connectionInfo_.tcpBufSize_));
+    int bytesOfData(0);
+    if (DataTypes::data == header[1]) {
+        if (header[0] > connectionInfo_.tcpBufSize_ - 16) {
+            set_error("Wrong size of data in block");
+            return -1;
+        }
+        bytesOfData = static_cast<int>(header[0]);
+        memcpy(data, pBlock + 16, header[0]);
+    } else if (DataTypes::compressed == header[1]) {
+        if (header[0] > connectionInfo_.tcpBufSize_ - 16) {
+            set_error("Wrong size of data in block");
+            return -1;
+        }
+        bytesOfData = compression::unpack(pBlock + 16, size_t(header[0]), data, size_t(length));
+        if (bytesOfData < 0) {
+            set_error("Error of decompression of block");
+            return -1;
+        }
+    } else {
+        is_terminate = DataTypes::service == header[1] && (ControlTags::terminate == header[2] || ControlTags::terminate == header[3]);
+    }
     SleepMs(connectionInfo_.delayRcvMs_);
 
     return bytesOfData;
@@ -558,29 +1519,14 @@ int TCPClient::receive(char *data, int length)
         std::cerr << "TCPClient::receive: Wrong input parameters." << std::endl;
         return 0;
     }
-    auto idxSocketRcv(connection_.iSocketRcv_++);
-    if (connection_.iSocketRcv_ == connection_.sockfd_rcv_.size()) {
-        connection_.iSocketRcv_ = 0;
-    }
-    uint32_t bytesRcv(0);
-    while (bytesRcv < connectionInfo_.tcpBufSize_) {
-        auto t1 = std::chrono::high_resolution_clock::now();
-        auto bytes = ::recv(connection_.sockfd_rcv_[idxSocketRcv], data + bytesRcv,
-                            static_cast<int>(connectionInfo_.tcpBufSize_ - bytesRcv), MSG_WAITALL);
-        //auto t2 = std::chrono::high_resolution_clock::now();
-        if (bytesReceived_ > 0) {
-            //receivedTime_ += t2 - t1;
-            receivedTime_ += std::chrono::duration<uint64_t, std::nano>(std::chrono::high_resolution_clock::now() - t1).count();
-        }
-
-        if (bytes < 0) {
-            set_error("Error read from socket");
-            return bytes;
-        } else {
-            bytesRcv += static_cast<uint32_t>(bytes);
-        }
+    auto idxSocketRcv(next_rcv_socket());
+    auto bytes = read_socket(idxSocketRcv, data, connectionInfo_.tcpBufSize_);
+    if (bytes < 0) {
+        set_error("Error read from socket");
+        return bytes;
     }
-    bytesReceived_ += bytesRcv;
+    auto bytesRcv = static_cast<uint32_t>(bytes);
+    received_.add(bytesRcv);
     if (connectionInfo_.displayRaw_) {
         display_data(data, static_cast<size_t>(length), "Received buffer from socket #" +
                      std::to_string(idxSocketRcv + 1) +
@@ -595,23 +1541,86 @@ int TCPClient::receive_need(char *data, int length)
     if (data == nullptr) {
         return 0;
     }
-    auto stayLength(length);
-    for (;;) {
-        int bytesReceived = receive(data + (length - stayLength), stayLength);
-        if (bytesReceived < 0) {
+    if (get_error() != 0) {
+        return -2;
+    }
+    // the data is taken byte by byte from the socket of current block, the socket
+    // is changed at the end of block as for receive()
+    const size_t bufSize(connectionInfo_.tcpBufSize_);
+    size_t received(0);
+    while (received < static_cast<size_t>(length)) {
+        if (0 == rcvBlockOffset_) {
+            rcvNeedSocket_ = next_rcv_socket();
+        }
+        auto idxSocketRcv(rcvNeedSocket_);
+        auto chunk = std::min(static_cast<size_t>(length) - received, bufSize - rcvBlockOffset_);
+        if (read_socket(idxSocketRcv, data + received, chunk) < 0) {
             auto err = GetLastError();
             std::cerr << err << " - Error read from socket" << std::endl;
-            return bytesReceived;
+            set_error("Error read from socket");
+            return -1;
         }
-        stayLength -= bytesReceived;
-        if (stayLength == 0) {
-            break;
+        received += chunk;
+        received_.add(chunk);
+        rcvBlockOffset_ += chunk;
+        if (rcvBlockOffset_ == bufSize) {
+            rcvBlockOffset_ = 0;
         }
     }
 
     return length;
 }
 
+bool TCPClient::finish_transfer()
+{
+    wait_async();
+    if (!flush()) {
+        return false;
+    }
+    // every send socket got a terminate tag, the first one is taken by the receiver of transfer
+    for (size_t i = 1; i < connection_.sockfd_rcv_.size(); ++i) {
+        auto idxSocketRcv(next_rcv_socket());
+        auto pBlock = receive_block(idxSocketRcv);
+        if (pBlock == nullptr) {
+            set_error("Error read from socket");
+            return false;
+        }
+        uint64_t header[4];
+        memcpy(header, pBlock, std::min<size_t>(sizeof(header), connectionInfo_.tcpBufSize_));
+        if (!(DataTypes::service == header[1] && (ControlTags::terminate == header[2] || ControlTags::terminate == header[3]))) {
+            set_error("Unexpected block after terminate tag");
+            return false;
+        }
+    }
+    // the sockets are used further by turns, so the send and the receive sides stay in step
+    rcvBlockOffset_ = 0;
+    sent_.reset();
+    received_.reset();
+    for (auto &state : connection_.states_) {
+        if (state) {
+            state->reset();
+        }
+    }
+    return true;
+}
+
+bool TCPClient::skip_need(uint64_t length)
+{
+    PooledBlock block(*blockPool_);
+    if (block.data() == nullptr) {
+        return false;
+    }
+    const auto bufSize = static_cast<uint64_t>(blockPool_->block_size());
+    while (length > 0) {
+        auto chunk = std::min(length, bufSize);
+        if (receive_need(block.data(), static_cast<int>(chunk)) < 0) {
+            return false;
+        }
+        length -= chunk;
+    }
+    return true;
+}
+
 int TCPClient::receive_tcp_io(char *pdata, int length)
 {
     if (pdata == nullptr) {
@@ -619,9 +1628,13 @@ int TCPClient::receive_tcp_io(char *pdata, int length)
     }
 
     auto bufSize = get_connection_info().tcpBufSize_;
-    std::vector<uint64_t> dataBuf(static_cast<size_t>(bufSize / 8));
-    auto pBufChar = reinterpret_cast<char *>(&dataBuf[0]);
-    auto pDataChar = reinterpret_cast<char *>(&dataBuf[2]);
+    PooledBlock block(*blockPool_);
+    if (block.data() == nullptr) {
+        return -1;
+    }
+    auto dataBuf = block.words();
+    auto pBufChar = block.data();
+    auto pDataChar = block.data() + 16;
     uint64_t readBytes(0);
     bool exit(false);
     do {
@@ -776,7 +1789,12 @@ void TCPClient::set_error(const std::string &msg)
     } else {
         out_str("ERROR: " + std::to_string(lastError_) + " " + msg + ".", std::cerr);
     }
-    disconnect();
+    if (sendQueue_ || rcvQueue_) {
+        // the other queue can use the sockets, they are closed by disconnect() after wait_async()
+        shutdown_sockets();
+    } else {
+        disconnect();
+    }
 }
 
 int TCPClient::get_error()
@@ -832,13 +1850,7 @@ StatusInfo ReceiveChunks::receive_header()
             needBytesRecieve_ = dataSize_;
         } else if (DataTypes::padding == conrolFrame) {
             status_ = StatusInfo::DataPadding;
-            std::vector<char> tmpBuf(static_cast<size_t>(dataSize_));
-            readBytes = client_->receive_need(&tmpBuf.front(), static_cast<int>(dataSize_));
-            if (readBytes == dataSize_) {
-                status_ = StatusInfo::AllData;
-            } else {
-                status_ = StatusInfo::Error;
-            }
+            status_ = client_->skip_need(dataSize_) ? StatusInfo::AllData : StatusInfo::Error;
         } else {
             DISPLAY_INFO("Unsupported cotrol tag.");
             status_ = StatusInfo::UnsupportTag;
@@ -878,16 +1890,12 @@ int ReceiveChunks::receive_data_block(char *data, int length)
             size_t padding = (dataSize_ + 16) % client_->get_connection_info().tcpBufSize_;
             if (padding > 0) {
                 padding = client_->get_connection_info().tcpBufSize_ - padding;
-                std::vector<char> dataPad(padding);
-                client_->receive_need(&dataPad.front(), int(padding));
+                client_->skip_need(padding);
             }
             /// We read bytes which were added for alignment to 8
             size_t bytesForPad8 = dataSize_ % 8;
             if (bytesForPad8 > 0) {
-                std::vector<char> dataPad(8 - bytesForPad8);
-                auto bytesRead = client_->receive_need(&dataPad.front(),
-                                                       static_cast<int>(dataPad.size()));
-                if (bytesRead != dataPad.size()) {
+                if (!client_->skip_need(8 - bytesForPad8)) {
                     status_ = StatusInfo::Error;
                     return bytesReceived;
                 }
@@ -921,12 +1929,11 @@ uint64_t SendChunks::getDataSize()
 
 int SendChunks::send_header()
 {
-    std::vector<char> header(16);
-    uInt64ToChar8(dataSize_, &header.front());
+    char header[16];
+    uInt64ToChar8(dataSize_, &header[0]);
     uInt64ToChar8(DataTypes::data, &header[8]);
-    auto sent_bytes = client_->send_need((char *)&header.front(),
-                                         static_cast<int>(header.size()));
-    if (header.size() == sent_bytes) {
+    auto sent_bytes = client_->send_need(header, static_cast<int>(sizeof(header)));
+    if (sizeof(header) == sent_bytes) {
         status_ = StatusInfo::DataProcessing;
     } else {
         status_ = StatusInfo::Error;
@@ -956,8 +1963,8 @@ int SendChunks::send_data_block(char *data, int length)
         status_ = StatusInfo::AllData;
         size_t bytesForPad8 = 8 - (dataSize_ % 8);
         if (bytesForPad8 < 8) {
-            std::vector<char> dataPad(bytesForPad8, '\0');
-            bytesSent += client_->send_need(&dataPad.front(), static_cast<int>(dataPad.size()));
+            char dataPad[8] = { 0 };
+            bytesSent += client_->send_need(dataPad, static_cast<int>(bytesForPad8));
         }
     }
     return bytesSent;
@@ -980,12 +1987,12 @@ int SendBlocks::send_header()
     //        return bytesBlockSize;
     //    }
     //    bytesSent += bytesBlockSize;
-    std::vector<char> header(16);
-    uInt64ToChar8(dataSize_, &header.front());
+    char header[16];
+    uInt64ToChar8(dataSize_, &header[0]);
     uInt64ToChar8(DataTypes::data, &header[8]);
-    auto bytesHeader = client_->send_need(&header.front(), int(header.size()));
+    auto bytesHeader = client_->send_need(header, int(sizeof(header)));
 
-    if (header.size() == bytesHeader) {
+    if (sizeof(header) == bytesHeader) {
         status_ = StatusInfo::DataProcessing;
         bytesSent += bytesHeader;
     } else {
@@ -8,6 +8,17 @@
 #include <vector>
 #include <mutex>
 #include <chrono>
+#include <memory>
+#include <functional>
+#include <future>
+#include <deque>
+#include <atomic>
+#include <condition_variable>
+#include "cachealigned.h"
+#include "tcpinstrument.h"
+#include "tcphistogram.h"
+#include "tcpcompress.h"
+#include <algorithm>
 
 #ifdef _WIN32
 
@@ -29,11 +40,13 @@ typedef SOCKET DS_SOCKET;
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <cstring>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/uio.h>
 #define GetLastError() errno
 #define D_EWOULDBLOCK 11
 typedef unsigned long long DS_SOCKET;
@@ -71,6 +84,8 @@ namespace DataTypes {
 const uint64_t data = 0x00;
 const uint64_t service = 0x01;
 const uint64_t padding = 0x02;
+/// Payload compressed by the codec of connection (compression::pack), only if the server advertises the codec
+const uint64_t compressed = 0x03;
 }
 
 /// Enum of state of TCP connection
@@ -81,14 +96,129 @@ enum ConnectionState {
     Disconnected
 };
 
+/// Engine of sending/receiving of blocks
+enum IoMode : int {
+    /// Blocking send/recv, sockets are used by turns in the calling thread
+    Blocking = 0,
+    /// Non-blocking sockets driven by epoll, every socket makes progress independently
+    EventLoop = 1,
+    /// io_uring with registered buffers, operations of all sockets are submitted together
+    IoUring = 2,
+    /// Worker thread per socket, all sockets are written (read) at the same time
+    Threaded = 3
+};
+
+/// Choice of send socket for every block
+enum SchedulerType : int {
+    /// Sockets by turns, as the server sends the blocks back (compatible with every server)
+    RoundRobin = 0,
+    /// Socket with the least unsent bytes, the server must echo every block on its pair of socket
+    LeastLoaded = 1,
+    /// Sockets in proportion to their recent throughput, the server must echo every block on its pair of socket
+    Weighted = 2
+};
+
+class BlockTransport;
+class SendScheduler;
+class ZeroCopySender;
+class AsyncQueue;
+class BlockPool;
+
+/// Completion of block sent by TCPClient::send_zc(), the buffer of block can be reused after it
+typedef std::function<void()> SendCompletion;
+/// Completion of asynchronous operation of TCPClient, the parameter is the result of operation
+typedef std::function<void(int)> AsyncCompletion;
+
+/// Part of data for the gather send, data_ == nullptr means length_ zero bytes
+struct DataPart {
+    const char *data_;
+    size_t length_;
+};
+
+/**
+ * @brief Counters of one direction of TCPClient or of one socket.
+ * Every counter has one writer thread, any thread reads them without lock.
+ */
+struct IoCounters {
+    std::atomic<uint64_t> bytes_;
+    /// Count of send (receive) operations
+    std::atomic<uint64_t> ops_;
+    /// Time of sending (receiving), nanoseconds
+    std::atomic<uint64_t> timeNs_;
+    /// Last error (errno), 0 - no error
+    std::atomic<int> error_;
+    /// Bytes and operations since the creation, they are not cleared by reset() (monotonic counters of metrics)
+    std::atomic<uint64_t> totalBytes_;
+    std::atomic<uint64_t> totalOps_;
+    //------------------------------------------------
+    IoCounters() : bytes_(0), ops_(0), timeNs_(0), error_(0), totalBytes_(0), totalOps_(0) {}
+    /// The bytes are published with release, so the reader of bytes_ sees the data of them (window of sending)
+    void add(const uint64_t bytes)
+    {
+        bytes_.fetch_add(bytes, std::memory_order_release);
+        ops_.fetch_add(1, std::memory_order_relaxed);
+        totalBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        totalOps_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void add_time(const uint64_t ns)
+    {
+        timeNs_.fetch_add(ns, std::memory_order_relaxed);
+    }
+    void reset()
+    {
+        bytes_.store(0, std::memory_order_relaxed);
+        ops_.store(0, std::memory_order_relaxed);
+        timeNs_.store(0, std::memory_order_relaxed);
+        error_.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief State of one socket. The send and the receive counters are on separate cache lines,
+ * so the sending and the receiving threads of duplex socket do not share a line.
+ */
+struct SocketState {
+    DS_SOCKET sock_;
+    /// Number of socket from server (socketID)
+    size_t id_;
+    bool isSend_;
+    bool isReceive_;
+    alignas(64) IoCounters sent_;
+    alignas(64) IoCounters received_;
+    /// Latencies of timed operations (ConnectionInfo::instrumentMode_): sending of block by the sending thread,
+    /// receiving (of block or of its part by receive_need()) and gap from the header of block to its end
+    /// (IoMode::Blocking) by the receiving thread
+    LatencyHistogram sendLatency_;
+    alignas(64) LatencyHistogram rcvLatency_;
+    LatencyHistogram gapLatency_;
+    //------------------------------------------------
+    SocketState() : sock_(0), id_(0), isSend_(false), isReceive_(false) {}
+    void reset()
+    {
+        sent_.reset();
+        received_.reset();
+        sendLatency_.reset();
+        rcvLatency_.reset();
+        gapLatency_.reset();
+    }
+};
+
 /**
  * @brief Struct for storage of phisical info about TCP connection
+ * @par sockfd_send_ and sockfd_rcv_ are the lanes of sending and receiving (the engines take them as is),
+ * the state of every socket is in states_
  */
 struct Connection {
     std::vector<DS_SOCKET> sockfd_;
     std::vector<DS_SOCKET> sockfd_send_;
     std::vector<DS_SOCKET> sockfd_rcv_;
-    ConnectionState state_;
+    /// States of sockets by socketID, every state is on its own cache lines
+    std::vector<cachealigned::Ptr<SocketState>> states_;
+    /// States of send (receive) lanes, they point to states_
+    std::vector<SocketState *> sendStates_;
+    std::vector<SocketState *> rcvStates_;
+    /// It is read by the threads of async queues while disconnect() changes it
+    std::atomic<ConnectionState> state_;
     struct hostent *server_;
     struct sockaddr_in server_addr_;
     size_t iSocketSend_;
@@ -100,6 +230,56 @@ struct Connection {
     }
 };
 
+/**
+ * @brief Options of TCP which are set to every socket before its connect.
+ * The options which are not supported by the system are skipped with message.
+ */
+struct SocketOptions {
+    /// TCP_NODELAY, small sends are not delayed by Nagle algorithm
+    bool noDelay_;
+    /// TCP_CORK (Linux), only full segments are sent, the tail is pushed by TCPClient::flush()
+    bool cork_;
+    /// TCP_NOTSENT_LOWAT (Linux), max not sent bytes in socket buffer, 0 - system default
+    int notSentLowat_;
+    /// TCP_CONGESTION (Linux), name of congestion control algorithm (e.g. "bbr"), empty - system default
+    std::string congestion_;
+    /// SO_BUSY_POLL (Linux), microseconds of busy polling of receive queue, 0 - off
+    int busyPollUs_;
+    /// Bandwidth of link for sizing of socket buffers, Mbit/s, 0 - the buffers are raised only to block size
+    uint32_t bandwidthMbps_;
+    /// Round trip time of link for sizing of socket buffers, microseconds
+    uint32_t rttUs_;
+    //------------------------------------------------
+    SocketOptions() : noDelay_(false), cork_(false), notSentLowat_(0), congestion_(""), busyPollUs_(0), bandwidthMbps_(0), rttUs_(0)
+    {
+        ;
+    }
+    /// Bulk transfer: buffers of bandwidth-delay product of 10 Gbit/s x 2 ms, bbr congestion control
+    static SocketOptions throughput()
+    {
+        SocketOptions opt;
+        opt.congestion_ = "bbr";
+        opt.bandwidthMbps_ = 10000;
+        opt.rttUs_ = 2000;
+        return opt;
+    }
+    /// Request/response: no Nagle delay, small not sent queue, busy polling of receive
+    static SocketOptions latency()
+    {
+        SocketOptions opt;
+        opt.noDelay_ = true;
+        opt.notSentLowat_ = 16384;
+        opt.busyPollUs_ = 50;
+        return opt;
+    }
+    /// Size of buffer of one of "nSockets" sockets which share the link, 0 - not set
+    int buffer_size(const size_t nSockets) const
+    {
+        const uint64_t bdp = uint64_t(bandwidthMbps_) * rttUs_ / 8;
+        return int(std::min<uint64_t>(bdp / std::max<size_t>(1, nSockets), 0x7FFFFFFF));
+    }
+};
+
 /** @enum ConnectionInfo
  * @brief Struct for storage of info about connection
  */
@@ -116,9 +296,43 @@ struct ConnectionInfo {
     int delayAfterConnect_;
     int timeOut_;
     int waitConnect_;
+    IoMode ioMode_;
+    /// Size of queue of every socket in blocks (receive buffer of IoMode::Blocking, queues of the engines)
+    uint32_t ioQueueDepth_;
+    /// Send blocks by TCPClient::send_zc() with MSG_ZEROCOPY (only IoMode::Blocking)
+    bool zeroCopy_;
+    /// Blocks smaller than this size are copied, pinning of pages costs more than copying of them
+    uint32_t zeroCopyMinSize_;
+    /// Count of blocks between the file reader thread and the sending thread (0 - file is read by the sending thread)
+    uint32_t pipelineDepth_;
+    /// Max count of asynchronous operations in flight of every direction (send_async, receive_async)
+    uint32_t asyncDepth_;
+    /// First pause before retry of failed connect, milliseconds, the pause is doubled after every retry
+    int connectRetryMs_;
+    SocketOptions socketOptions_;
+    SchedulerType scheduler_;
+    /// Max bytes which are sent and not received back, the sender waits for the receiver (0 - no limit).
+    /// The blocks must be received in other thread (or by receive_async) while sending
+    uint64_t windowBytes_;
+    /// Max blocks which are sent and not received back, used if windowBytes_ is 0 (0 - no limit)
+    uint32_t windowBlocks_;
+    /// Timing of send/receive operations for the speed of network
+    InstrumentMode instrumentMode_;
+    /// One of this count of operations is timed in InstrumentMode::Sampled
+    uint32_t instrumentSampleRate_;
+    /// Codec of payloads of sent blocks, used if the server advertises it in the socketconfig block
+    CompressionCodec compression_;
+    /// Level of Zstandard, acceleration of LZ4
+    int compressionLevel_;
+    /// Threads of compression of send pipeline (0 - one per core)
+    uint32_t compressThreads_;
     //------------------------------------------------
     ConnectionInfo() : port_(0), remoteAddress_(""), tcpBufSize_(128), displayRaw_(false), delayRcvMs_(0), delaySendMs_(0),
-        nSockets_(1), exit_(false), isDuplexSockets_(false), delayAfterConnect_(0), timeOut_(0), waitConnect_(0)
+        nSockets_(1), exit_(false), isDuplexSockets_(false), delayAfterConnect_(0), timeOut_(0), waitConnect_(0),
+        ioMode_(IoMode::Blocking), ioQueueDepth_(16), zeroCopy_(false), zeroCopyMinSize_(16384),
+        pipelineDepth_(8), asyncDepth_(16), connectRetryMs_(10), scheduler_(SchedulerType::RoundRobin),
+        windowBytes_(0), windowBlocks_(0), instrumentMode_(InstrumentMode::Full), instrumentSampleRate_(64),
+        compression_(CompressionCodec::Uncompressed), compressionLevel_(1), compressThreads_(0)
     {
         ;
     }
@@ -236,6 +450,13 @@ public:
      * @return -1 - if error, else count of sending bytes
      */
     int send_terminate_exit();
+    /**
+     * @brief Prepare the connection for the next transfer after the terminate tag is received:
+     * the terminate tags of the other receive sockets are read and the counters are reset,
+     * so many transfers are done without new connect and configSocket handshakes
+     * @return false if error, the connection is closed
+     */
+    bool finish_transfer();
     /**
      * @brief Send data to tcp server
      * @param data - pointer to data
@@ -243,6 +464,43 @@ public:
      * @return -1 - if error, else count of sending bytes
      */
     int send(const char *data, int length);
+    /**
+     * @brief Send one block to tcp_io component: the header, the data and the zero padding
+     * up to size of block, without copying of data to a block buffer
+     * @param data - pointer to data
+     * @param length - length of data, not more than tcpBufSize_ - 16
+     * @param dataType - type of data (DataTypes)
+     * @return -1 - if error, else count of sending bytes
+     */
+    int send_block(const char *data, int length, uint64_t dataType = DataTypes::data);
+    /**
+     * @brief Send data to tcp server without copying it to the socket buffer (MSG_ZEROCOPY)
+     * @par The buffer must not be changed or freed until "done" is called. If zero-copy is not
+     * enabled (ConnectionInfo::zeroCopy_) or the data is smaller than ConnectionInfo::zeroCopyMinSize_
+     * the data is copied and "done" is called before return.
+     * @param data - pointer to data
+     * @param length - length of data
+     * @param done - completion of sending, it is called in the calling thread of TCPClient
+     * @return -1 - if error, else count of sending bytes
+     */
+    int send_zc(const char *data, int length, const SendCompletion &done);
+    /**
+     * @brief Call the completions of blocks sent by send_zc() which the kernel has released
+     * @param wait - wait for at least one completion if there are pending blocks
+     * @return false if error
+     */
+    bool poll_send_completions(bool wait);
+#ifndef _WIN32
+    /**
+     * @brief Send \"length\" bytes of file from \"offset\" to next socket, the data is not copied
+     * through user space (sendfile). If an I/O engine is used the data is read to a buffer.
+     * @param fd - descriptor of file
+     * @param offset - offset of data in file
+     * @param length - length of data, usually one block
+     * @return -1 - if error, else count of sending bytes
+     */
+    int send_file(int fd, int64_t offset, int length);
+#endif
     /**
      * @brief Send \"length\" bytes of data to TCP server
      * @param data - pointer to data for reaading
@@ -266,6 +524,11 @@ public:
      * @return -1 - if error, else counter of the received bytes
      */
     int receive_need(char *data, int length);
+    /**
+     * @brief Receive and drop \"length\" bytes of data (padding) as receive_need()
+     * @return false if error
+     */
+    bool skip_need(uint64_t length);
     /**
      * @brief Receive data from tcp_io component
      * @param data - pointer to data for reaading
@@ -291,7 +554,39 @@ public:
      * @return -1 - if error, else counter of the received bytes
      */
     int receive_sync(std::vector<char> &data);
+    /**
+     * @brief Wait until all data queued by the I/O engine is written to the sockets
+     * @return true if all data is written, false if else
+     */
+    bool flush();
+    /**
+     * @brief Send a block asynchronously, the operations are done in order of calls by one worker thread
+     * @par The buffer must be kept until completion. If ConnectionInfo::asyncDepth_ operations are
+     * in flight the call waits. The calls must be made from one thread.
+     * @param data - pointer to data (block)
+     * @param length - length of data
+     * @param done - completion, it is called in the worker thread with the result of send()
+     */
+    void send_async(const char *data, int length, const AsyncCompletion &done);
+    /// Send a block asynchronously, the future gets the result of send()
+    std::future<int> send_async(const char *data, int length);
+    /**
+     * @brief Receive a block asynchronously, the operations are done in order of calls by one worker thread
+     * @param data - pointer to buffer, it must be kept until completion
+     * @param length - size of buffer
+     * @param done - completion, it is called in the worker thread with the result of receive()
+     */
+    void receive_async(char *data, int length, const AsyncCompletion &done);
+    /// Receive a block asynchronously, the future gets the result of receive()
+    std::future<int> receive_async(char *data, int length);
+    /// Wait of completion of all asynchronous operations, must be called before synchronous calls
+    void wait_async();
     void set_display(const bool displayRaw);
+    /// Pool of buffers of size of block (tcpBufSize_) for processing of blocks without allocations
+    BlockPool &get_block_pool()
+    {
+        return *blockPool_;
+    }
     ConnectionInfo &get_connection_info()
     {
         return connectionInfo_;
@@ -300,30 +595,62 @@ public:
     {
         return connection_;
     }
+    /// The counters may be read from any thread
     uint64_t get_bytes_sent() const
     {
-        return bytesSent_;
+        return sent_.bytes_.load(std::memory_order_relaxed);
     }
     uint64_t get_bytes_received() const
     {
-        return bytesReceived_;
+        return received_.bytes_.load(std::memory_order_relaxed);
     }
+    /// Bytes since the creation of client, they are not reset by finish_transfer()
+    uint64_t get_total_bytes_sent() const
+    {
+        return sent_.totalBytes_.load(std::memory_order_relaxed);
+    }
+    uint64_t get_total_bytes_received() const
+    {
+        return received_.totalBytes_.load(std::memory_order_relaxed);
+    }
+    /// Time of sending (receiving), 0 if the timing is off (ConnectionInfo::instrumentMode_)
     double get_sent_time_ms() const
     {
-        auto ms = (std::chrono::duration<uint64_t, std::nano>(sentTime_)).count();
-        return double(ms / 1000000);
+        auto ns = sent_.timeNs_.load(std::memory_order_relaxed);
+        return double(ns) / 1000000;
     }
     double get_received_time_ms() const
     {
-        auto ms = std::chrono::duration<uint64_t, std::nano>(receivedTime_).count();
-        return double(ms / 1000000);
+        auto ns = received_.timeNs_.load(std::memory_order_relaxed);
+        return double(ns) / 1000000;
+    }
+    const Instrument &get_send_instrument() const
+    {
+        return sendInstrument_;
+    }
+    const Instrument &get_receive_instrument() const
+    {
+        return rcvInstrument_;
+    }
+    /// Codec of payloads of this connection: the requested one if the server and the build have it
+    CompressionCodec get_codec() const
+    {
+        return codec_;
+    }
+    /// Codecs of server (mask of compression::bit()), 0 - the server does not decompress
+    uint64_t get_server_codecs() const
+    {
+        return serverCodecs_;
+    }
+    /// States of sockets of last connection by socketID (counters of every socket)
+    const std::vector<cachealigned::Ptr<SocketState>> &get_socket_states() const
+    {
+        return connection_.states_;
     }
     void SleepMs(int sleepMs);
     int get_error();
     static void out_str(const std::string &str, std::ostream &stream);
 
-    uint64_t bytesSent_;
-    uint64_t bytesReceived_;
 private:
     const int wait_step_sec = 5;
     void set_error(const std::string &msg);
@@ -331,6 +658,54 @@ private:
     std::string getHostByName(const std::string &host) const;
     void setTimeout(const DS_SOCKET sock, const bool is_receive, long to);
     void setTimeout(long to);
+    /**
+     * @brief Open "count" sockets to server at the same time (non-blocking connect), failed connects are
+     * retried with growing pause until ConnectionInfo::waitConnect_ is expired
+     * @return false if not all sockets are connected, the opened sockets are closed
+     */
+    bool connect_sockets(const size_t count, std::vector<DS_SOCKET> &sockets);
+    /// Mark the connection as disconnected and release the threads which wait in send/recv, the sockets stay open
+    void shutdown_sockets();
+    /// Set ConnectionInfo::socketOptions_ to socket
+    void set_socket_options(const DS_SOCKET sock);
+    /// Print the options of socket which are set by the system
+    void print_socket_options(const DS_SOCKET sock);
+    /// Choice of codec of connection by ConnectionInfo::compression_ and the codecs of server and of build
+    void negotiate_codec();
+    /**
+     * @brief Read data from socket to the receive buffer, at least \"need\" bytes are buffered after it
+     * @param tHeader - if not nullptr and not 0, it is set to the ticks when the header of block is buffered
+     */
+    int fill_rcv_buffer(const size_t idxSocket, const size_t need, uint64_t *tHeader = nullptr);
+    /// Read exactly \"length\" bytes from receive socket (through the receive buffer or the engine)
+    int read_socket(const size_t idxSocket, char *data, const size_t length);
+    /// Receive one block from socket, returns pointer to the block or nullptr if error
+    const char *receive_block(const size_t idxSocket);
+    /// Index of next socket for sending (round-robin or by ConnectionInfo::scheduler_)
+    size_t next_send_socket();
+    /// Index of next socket for receiving, the sockets are taken in order of sending
+    size_t next_rcv_socket();
+    /// Put the send socket of block to the log of receive order (not round-robin scheduler)
+    void log_send_socket(const size_t idxSocket);
+    /// Send parts of data to next socket by one system call
+    int send_parts(const DataPart *parts, const size_t count);
+    int send_parts(const DataPart *parts, const size_t count, const size_t idxSocket);
+    /**
+     * @brief Wait until the data of "length" bytes fits to the window of ConnectionInfo
+     * @return false if the connection is closed or time out is expired
+     */
+    bool wait_window(const size_t length);
+    /// Count the result of operation of lane in the state of its socket: bytes or errno if result < 0,
+    /// the time ns of operation is put to the histogram of socket if it is timed (not 0)
+    void count_socket(const bool isSend, const size_t idxSocket, const int64_t result, const uint64_t ns = 0);
+    /// Read from lane through the receive buffer (IoMode::Blocking), tHeader as of fill_rcv_buffer() (0 - not known)
+    int read_buffered(const size_t idxSocket, char *data, const size_t length, uint64_t *tHeader = nullptr);
+    /// Put the time from the header of block (ticks of tHeader, 0 - not timed) to the gap histogram of lane
+    void count_gap(const size_t idxSocket, const uint64_t tHeader);
+    /// Send block of service tags to every send socket
+    int send_service_tags(const uint64_t *tags, const size_t count);
+    /// Create engines of sending/receiving according to ConnectionInfo::ioMode_
+    bool create_transports();
     /// Struct for storage of info about connection
     ConnectionInfo connectionInfo_;
     /// Struct for storage of phisical info about TCP connection
@@ -339,9 +714,58 @@ private:
     //std::vector<char> tcpRcvVec_;
     //std::vector<char> tcpTmpBuf_;
     static std::mutex mutex_;
-    uint64_t sentTime_;
-    uint64_t receivedTime_;
-    int lastError_;
+    /// Counters of sending (the sending thread) and of receiving (the receiving thread)
+    alignas(64) IoCounters sent_;
+    alignas(64) IoCounters received_;
+    std::atomic<int> lastError_;
+    /// Timers of sending (the sending thread) and of receiving (the receiving thread)
+    alignas(64) Instrument sendInstrument_;
+    alignas(64) Instrument rcvInstrument_;
+    /// Codec negotiated by configSocket() and the codecs which the server advertises
+    CompressionCodec codec_;
+    uint64_t serverCodecs_;
+    /// Engines for the send and the receive sockets, empty for IoMode::Blocking
+    std::unique_ptr<BlockTransport> sendTransport_;
+    std::unique_ptr<BlockTransport> rcvTransport_;
+    /// Scheduler of send sockets, empty for SchedulerType::RoundRobin (it uses the engine, so it is destroyed before)
+    std::unique_ptr<SendScheduler> scheduler_;
+    /// Send sockets of blocks in order of sending, the blocks are received in this order
+    std::deque<uint32_t> laneLog_;
+    std::mutex laneLogMutex_;
+    std::condition_variable laneLogCv_;
+    /// Receive socket of the block which is taken by receive_need()
+    size_t rcvNeedSocket_;
+    /// Window of sending in bytes (sent_.bytes_ - received_.bytes_), 0 - no limit
+    uint64_t window_;
+    /// Received and not processed data of one receive socket (IoMode::Blocking)
+    struct RcvBuffer {
+        std::vector<char> buf_;
+        /// Offset of first not processed byte
+        size_t head_;
+        /// Count of not processed bytes
+        size_t size_;
+        RcvBuffer() : head_(0), size_(0) {}
+    };
+    std::vector<RcvBuffer> rcvBuffers_;
+    /// Bytes of current block which are taken by receive_need()
+    size_t rcvBlockOffset_;
+    /// Block received from an engine by receive_data(), it is taken from blockPool_
+    char *rcvBlock_;
+    std::unique_ptr<BlockPool> blockPool_;
+    /// Zero-copy sending, empty if ConnectionInfo::zeroCopy_ is not set or not supported
+    std::unique_ptr<ZeroCopySender> zeroCopySender_;
+    /// Zero bytes for padding of blocks
+    std::vector<char> zeroPad_;
+    /// Workers of send_async() and receive_async(), they are created by the first call
+    /// and destroyed before the engines
+    std::unique_ptr<AsyncQueue> sendQueue_;
+    std::unique_ptr<AsyncQueue> rcvQueue_;
+#ifdef _WIN32
+    std::vector<char> stagingBuf_;
+#else
+    /// Buffer of send_file() when data is read from file
+    std::vector<char> fileBuf_;
+#endif
 //    std::chrono::duration<double, std::milli> sentTimeMs_;
 //    std::chrono::duration<double, std::milli> receivedTimeMs_;
 };
@@ -1,7 +1,15 @@
 #include "tcpclientapp.h"
+#include "spscring.h"
+#include "tcptrace.h"
 
 #include <future>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
 
 
 namespace utils {
@@ -10,7 +18,7 @@ std::mutex Timing::outMutex_;
 
 Timing::Timing(const std::string &title)
     : title_(title),
-      t_start_(std::chrono::high_resolution_clock::now()),
+      t_start_(instrument::ticks()),
       is_out_result_(false)
 {
     std::time_t t = std::time(nullptr);
@@ -33,8 +41,7 @@ Timing::~Timing()
 void Timing::outResultStr(const int64_t bytes)
 {
     is_out_result_ = true;
-    auto t_end = std::chrono::high_resolution_clock::now();
-    auto t_value = std::chrono::duration<double, std::milli>(t_end - t_start_).count();
+    auto t_value = double(instrument::to_ns(instrument::ticks() - t_start_)) / 1000000;
     auto speedByteSec = bytes * 1000 / t_value;
     std::string bitsStr(to_freindly_string(speedByteSec * 8));
     utils::replace_substr(bitsStr, "B", "bit");
@@ -48,8 +55,7 @@ void Timing::outResultStr(const int64_t bytes)
 void Timing::outResultStr()
 {
     is_out_result_ = true;
-    auto t_end = std::chrono::high_resolution_clock::now();
-    auto t_value = std::chrono::duration<double, std::milli>(t_end - t_start_).count();
+    auto t_value = double(instrument::to_ns(instrument::ticks() - t_start_)) / 1000000;
     outMutex_.lock();
     std::cout << title_ << " finished: " << utils::num_to_string(t_value) << " ms. = " << utils::num_to_string(t_value / 1000) <<
               " sec. "
@@ -59,7 +65,7 @@ void Timing::outResultStr()
 
 void Timing::reStart()
 {
-    t_start_ = std::chrono::high_resolution_clock::now();
+    t_start_ = instrument::ticks();
 }
 
 void Timing::outStr(const std::string &str)
@@ -81,7 +87,7 @@ void Timing::sleepMs(const int sleepMs)
 
 long long Timing::runTimesNano()
 {
-    return (std::chrono::high_resolution_clock::now() - t_start_).count();
+    return static_cast<long long>(instrument::to_ns(instrument::ticks() - t_start_));
 }
 
 StdInOutHandler::StdInOutHandler(std::string &inFile, std::string &outFile) : fileNameIn_(""), fileNameOut_(""), error_(0),
@@ -606,32 +612,106 @@ uint64_t normalizeBufSize(const uint64_t blockSize)
 
 } // namespace convertors
 
+namespace {
+/// Note of timing mode for the speed message
+std::string instrument_note(const Instrument &instrument)
+{
+    if (InstrumentMode::Sampled == instrument.mode()) {
+        return " (sampled 1/" + std::to_string(instrument.sample_rate()) + ")";
+    }
+    return "";
+}
+}  // namespace
+
 std::string get_send_speed_msg(TCPClient &client)
 {
-    auto t_ms = std::chrono::duration<double, std::milli>(client.get_sent_time_ms());
-    auto ms = t_ms.count();
-//    auto ms = client.get_sent_time_ms();
-    if (0 == ms) {
+    auto ms = client.get_sent_time_ms();
+    if (0 == ms || InstrumentMode::Off == client.get_send_instrument().mode()) {
         return "";
     }
     auto bytes = client.get_bytes_sent();
     auto speedByteSec = bytes * 1000 / ms;
-    std::string res = "Network speed of sending: " + to_freindly_string(speedByteSec) + "/s";
+    std::string res = "Network speed of sending: " + to_freindly_string(speedByteSec) + "/s" +
+                      instrument_note(client.get_send_instrument());
     return res;
 }
 
 std::string get_receive_speed_msg(TCPClient &client)
 {
     auto ms = client.get_received_time_ms();
-    if (0 == ms) {
+    if (0 == ms || InstrumentMode::Off == client.get_receive_instrument().mode()) {
         return "";
     }
     auto bytes = client.get_bytes_received();
     auto speedByteSec = bytes * 1000 / ms;
-    std::string res = "Network speed of receiving: " + to_freindly_string(speedByteSec) + "/s";
+    std::string res = "Network speed of receiving: " + to_freindly_string(speedByteSec) + "/s" +
+                      instrument_note(client.get_receive_instrument());
     return res;
 }
 
+std::string get_latency_msg(TCPClient &client)
+{
+    LatencyHistogram send, rcv, gap;
+    std::string res;
+    for (const auto &state : client.get_socket_states()) {
+        if (!state) {
+            continue;
+        }
+        std::string socket("Socket #" + std::to_string(state->id_));
+        if (state->sendLatency_.count() > 0) {
+            res += socket + " send:    " + state->sendLatency_.summary() + "\n";
+            send.merge(state->sendLatency_);
+        }
+        if (state->rcvLatency_.count() > 0) {
+            res += socket + " receive: " + state->rcvLatency_.summary() + "\n";
+            rcv.merge(state->rcvLatency_);
+        }
+        if (state->gapLatency_.count() > 0) {
+            res += socket + " gap:     " + state->gapLatency_.summary() + "\n";
+            gap.merge(state->gapLatency_);
+        }
+    }
+    if (send.count() > 0) {
+        res += "All send:    " + send.summary() + "\n";
+    }
+    if (rcv.count() > 0) {
+        res += "All receive: " + rcv.summary() + "\n";
+    }
+    if (gap.count() > 0) {
+        res += "All gap:     " + gap.summary() + "\n";
+    }
+    return res.empty() ? res : "Latencies of blocks:\n" + res;
+}
+
+int send_payload(TCPClient &client, const char *data, const int length, std::vector<char> &packed, uint64_t &wireBytes)
+{
+    const auto codec = client.get_codec();
+    if (CompressionCodec::Uncompressed != codec && length > 0) {
+        const size_t maxLength = client.get_connection_info().tcpBufSize_ - 16;
+        packed.resize(maxLength);
+        const auto size = compression::pack(codec, client.get_connection_info().compressionLevel_, data, size_t(length),
+                                            &packed.front(), maxLength);
+        if (size > 0) {
+            wireBytes += size;
+            return client.send_block(&packed.front(), static_cast<int>(size), DataTypes::compressed);
+        }
+    }
+    wireBytes += size_t(length);
+    return client.send_block(data, length);
+}
+
+std::string get_compression_msg(TCPClient &client, const uint64_t rawBytes, const uint64_t wireBytes)
+{
+    if (CompressionCodec::Uncompressed == client.get_codec() || 0 == wireBytes) {
+        return "";
+    }
+    std::string title("Compressed (" + std::string(compression::name(client.get_codec())) + "):");
+    title.resize(std::max<size_t>(35, title.size()), ' ');
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(2) << title << rawBytes << " -> " << wireBytes << " bytes of payload (x" << double(rawBytes) / wireBytes << ")\n";
+    return ss.str();
+}
+
 bool replace_substr(std::string &str, const std::string &from, const std::string &to)
 {
     size_t start_pos = str.find(from);
@@ -660,6 +740,17 @@ int status_out(std::vector<std::future<uint64_t>> &f_vec, TCPClient &client, con
         }
         utils::Timing::outStr("Sent/Received: " + utils::to_freindly_string(client.get_bytes_sent()) + "/" + utils::to_freindly_string(
                                   client.get_bytes_received()));
+        std::string perSocket;
+        for (const auto &state : client.get_socket_states()) {
+            if (state) {
+                perSocket += " #" + std::to_string(state->id_) + ":" + utils::to_freindly_string(
+                                 state->sent_.bytes_.load(std::memory_order_relaxed)) + "/" + utils::to_freindly_string(
+                                 state->received_.bytes_.load(std::memory_order_relaxed));
+            }
+        }
+        if (!perSocket.empty()) {
+            utils::Timing::outStr("Sockets:" + perSocket);
+        }
     }
     return client.get_error();
 }
@@ -677,66 +768,130 @@ TCPClientApp::~TCPClientApp()
 void TCPClientApp::sendDS8File(ConnectionInfo connectionInfo, const std::string &fileName,
                                const std::string &fileNameOut/* = ""*/)
 {
-    std::cout << __func__ << "(" << fileName << ") started.\n";
     std::ifstream ifs(fileName, std::ios::binary);
     if (!ifs) {
         std::cerr << "File \"" << std::string(fileName) << "\" not found.\n";
         return;
     }
+    uint32_t bufSize(1);
+    if (!utils::convertors::ds8binHeader::read(ifs, bufSize)) {
+        std::cerr << "Wrong type of file.\n";
+        return;
+    }
+    ifs.close();
+    TCPClient client;
+    connectionInfo.tcpBufSize_ = bufSize;
+    if (!client.initConnection(connectionInfo)) {
+        std::cerr << "Init error\n";
+        return;
+    }
+    if (!client.connect()) {
+        return;
+    }
+    sendDS8File(client, fileName, fileNameOut);
+}
+
+bool TCPClientApp::sendDS8File(TCPClient &client, const std::string &fileName,
+                               const std::string &fileNameOut/* = ""*/)
+{
+    std::cout << __func__ << "(" << fileName << ") started.\n";
+    Tracer::set_thread_name("sender");
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "File \"" << std::string(fileName) << "\" not found.\n";
+        return false;
+    }
     auto fileSize = utils::convertors::getFileSize(fileName);
     if (fileSize < utils::convertors::ds8binHeader::size()) {
         ifs.close();
         std::cerr << "Wrong size of file.\n";
-        return;
+        return false;
     }
     fileSize -= utils::convertors::ds8binHeader::size();
     uint32_t bufSize(1);
     if (!utils::convertors::ds8binHeader::read(ifs, bufSize)) {
         ifs.close();
         std::cerr << "Wrong type of file.\n";
-        return;
+        return false;
     }
     if (fileSize % bufSize != 0) {
         ifs.close();
         std::cerr << "Wrong size of file.\n";
-        return;
-    }
-    TCPClient client;
-    connectionInfo.tcpBufSize_ = bufSize;
-    if (!client.initConnection(connectionInfo)) {
-        std::cerr << "Init error\n";
-        return;
+        return false;
     }
-    if (!client.connect()) {
-        return;
+    // the blocks of file are sent as is, so they must have the size of block of connection
+    if (bufSize != client.get_connection_info().tcpBufSize_) {
+        ifs.close();
+        std::cerr << "Size of block of file " << bufSize << " is not equal to size of block of connection "
+                  << client.get_connection_info().tcpBufSize_ << ".\n";
+        return false;
     }
 
-    std::vector<char> data(static_cast<size_t>(bufSize));
-    auto pData = &data.front();
     auto nBlocks(fileSize / bufSize);
+#ifndef _WIN32
+    if (!client.get_connection_info().zeroCopy_) {
+        // the file is laid out as the blocks go to sockets, so every block is sent from file by sendfile
+        ifs.close();
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "File \"" << std::string(fileName) << "\" not opened.\n";
+            return false;
+        }
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        auto f_rcv = std::async(std::launch::async, receiveToDs8, std::ref(client),
+                                fileNameOut.empty() ? fileName + ".out" : fileNameOut);
+        auto offset = static_cast<int64_t>(utils::convertors::ds8binHeader::size());
+        for (int64_t i = 0; i < nBlocks; i++, offset += bufSize) {
+            if (client.send_file(fd, offset, static_cast<int>(bufSize)) < 0) {
+                break;
+            }
+        }
+        client.flush();
+        f_rcv.get();
+        ::close(fd);
+        return client.get_error() == 0;
+    }
+#endif
+    // with zero-copy the block is owned by kernel until its completion, so several blocks are used by turns
+    const size_t nBuffers(client.get_connection_info().zeroCopy_ ? 2 * client.get_connection().sockfd_send_.size() + 2 : 1);
+    std::vector<char> data(static_cast<size_t>(bufSize) * nBuffers);
+    std::vector<char> busy(nBuffers, 0);
     auto f_rcv = std::async(std::launch::async, receiveToDs8, std::ref(client),
                             fileNameOut.empty() ? fileName + ".out" : fileNameOut);
     int64_t i(0);
     for (; i < nBlocks; i++) {
+        const auto iBuf = static_cast<size_t>(i) % nBuffers;
+        while (busy[iBuf] && client.poll_send_completions(true)) {
+        }
+        if (busy[iBuf]) {
+            break;
+        }
+        auto pData = &data[iBuf * bufSize];
+        TraceSpan span("file read", "disk", "bytes", bufSize);
         ifs.read(pData, bufSize);
-        int bytesSent = client.send(pData, static_cast<int>(bufSize));
+        span.end();
+        busy[iBuf] = 1;
+        int bytesSent = client.send_zc(pData, static_cast<int>(bufSize), [&busy, iBuf]() {
+            busy[iBuf] = 0;
+        });
         if (bytesSent < 0) {
             break;
         }
     }
+    client.flush();
     f_rcv.get();
+    return client.get_error() == 0;
 }
 
 void TCPClientApp::sendBinFile(ConnectionInfo connectionInfo, const std::string &fileName,
                                const std::string &fileNameOut /*= ""*/)
 {
-    std::cout << __func__ << "(" << fileName << ") started.\n";
-    std::ifstream ifs(fileName, std::ios::binary);
-    if (!ifs) {
+    if (!std::ifstream(fileName, std::ios::binary)) {
         std::cerr << "File \"" << std::string(fileName) << "\" not found.\n";
         return;
     }
-
     TCPClient client;
     if (!client.initConnection(connectionInfo)) {
         std::cerr << "Init error\n";
@@ -745,45 +900,154 @@ void TCPClientApp::sendBinFile(ConnectionInfo connectionInfo, const std::string
     if (!client.connect()) {
         return;
     }
+    sendBinFile(client, fileName, fileNameOut);
+}
+
+bool TCPClientApp::sendBinFile(TCPClient &client, const std::string &fileName,
+                               const std::string &fileNameOut /*= ""*/)
+{
+    std::cout << __func__ << "(" << fileName << ") started.\n";
+    Tracer::set_thread_name("sender");
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "File \"" << std::string(fileName) << "\" not found.\n";
+        return false;
+    }
 
     auto fileSize = size_t(utils::convertors::getFileSize(fileName));
 
     auto bufSize = static_cast<size_t>(client.get_connection_info().tcpBufSize_);
     auto bufDataSize(bufSize - 16);
-    std::vector<utils::DS8WORD> data(static_cast<size_t>(bufSize / 8));
-    auto pBlock = data[0].c_8;
-    auto pData = data[2].c_8;
-    size_t readBytes(0);
-    auto dataSize(bufDataSize);
-    data[0].w_64 = static_cast<uint64_t>(dataSize);
-    data[1].w_64 = DataTypes::data;
-    size_t i(0);
-    auto needReadBytes(fileSize);
 
     auto f_rcv = std::async(std::launch::async, receiveToBin, std::ref(client),
                             fileNameOut.empty() ? fileName + ".out" : fileNameOut);
 
+    // payloads before and after compression
+    uint64_t rawBytes(0);
+    uint64_t wireBytes(0);
     utils::Timing tm("Sending");
-    do {
-        if (bufDataSize > needReadBytes) {
-            dataSize = needReadBytes;
-            memset(pData, 0, bufDataSize);
-            //data[0].w_64 = ((dataSize + 7) / 8) * 8;
-            data[0].w_64 = dataSize;
+    if (client.get_connection_info().pipelineDepth_ > 0) {
+        // the reader thread fills the payloads of blocks, this thread sends them,
+        // so reading of file and sending are overlapped
+        struct Block {
+            std::vector<char> data_;
+            size_t size_;
+            /// Last slot, the file is read (or the reading is failed)
+            bool last_;
+            /// Payload of compressed block, packedSize_ 0 - the block is sent uncompressed
+            std::vector<char> packed_;
+            size_t packedSize_;
+            /// The compression of block is finished by the thread of pool
+            std::atomic<bool> ready_;
+        };
+        SpscRing<Block> ring(client.get_connection_info().pipelineDepth_);
+        const auto codec = client.get_codec();
+        const auto level = client.get_connection_info().compressionLevel_;
+        // the blocks of ring are compressed at the same time, the sender takes them in order
+        std::unique_ptr<CompressPool> pool;
+        if (CompressionCodec::Uncompressed != codec) {
+            pool.reset(new CompressPool(client.get_connection_info().compressThreads_));
         }
-        ifs.read(pData, static_cast<int64_t>(dataSize));
-        auto bytesRead = ifs.gcount();
-        if (bytesRead < 1) {
-            break;
+        for (auto &block : ring.slots()) {
+            block.data_.resize(bufDataSize);
+            if (pool) {
+                block.packed_.resize(bufDataSize);
+            }
         }
-        int bytesSent = client.send(pBlock, static_cast<int>(bufSize));
-        if (bytesSent < 0) {
-            return;
+        bool stop(false);
+        std::thread reader([&]() {
+            Tracer::set_thread_name("file reader");
+            auto needReadBytes(fileSize);
+            for (;;) {
+                // nullptr - the sender is failed
+                Block *block = ring.wait_write_slot();
+                if (nullptr == block) {
+                    return false;
+                }
+                block->size_ = std::min(bufDataSize, needReadBytes);
+                if (block->size_ > 0) {
+                    TraceSpan span("file read", "disk", "bytes", static_cast<int64_t>(block->size_));
+                    ifs.read(&block->data_.front(), static_cast<int64_t>(block->size_));
+                    block->size_ = static_cast<size_t>(ifs.gcount());
+                }
+                needReadBytes -= block->size_;
+                block->last_ = 0 == block->size_ || 0 == needReadBytes;
+                block->packedSize_ = 0;
+                if (pool && block->size_ > 0) {
+                    block->ready_.store(false, std::memory_order_relaxed);
+                    pool->submit([block, codec, level, bufDataSize, &ring]() {
+                        TraceSpan span("compress", "cpu", "bytes", static_cast<int64_t>(block->size_));
+                        block->packedSize_ = compression::pack(codec, level, &block->data_.front(), block->size_,
+                                                               &block->packed_.front(), bufDataSize);
+                        block->ready_.store(true, std::memory_order_release);
+                        ring.notify();
+                    });
+                } else {
+                    block->ready_.store(true, std::memory_order_relaxed);
+                }
+                ring.push();
+                if (block->last_) {
+                    return false;
+                }
+            }
+        });
+        for (;;) {
+            // the reader is not failed before the last block, so the waits are not cancelled here
+            Block *block = ring.wait_read_slot();
+            ring.wait([block]() {
+                return block->ready_.load(std::memory_order_acquire);
+            });
+            int bytesSent(0);
+            if (block->packedSize_ > 0) {
+                bytesSent = client.send_block(&block->packed_.front(), static_cast<int>(block->packedSize_), DataTypes::compressed);
+            } else if (block->size_ > 0) {
+                bytesSent = client.send_block(&block->data_.front(), static_cast<int>(block->size_));
+            }
+            rawBytes += block->size_;
+            wireBytes += block->packedSize_ > 0 ? block->packedSize_ : block->size_;
+            if (bytesSent < 0) {
+                stop = true;
+                ring.cancel();
+                break;
+            }
+            auto last = block->last_;
+            ring.pop();
+            if (last) {
+                break;
+            }
         }
-        readBytes += dataSize;
-        needReadBytes = fileSize - readBytes;
-        ++i;
-    } while (needReadBytes > 0);
+        reader.join();
+        if (stop) {
+            return false;
+        }
+    } else {
+        // only the payload is read, the header and padding are added by send_block()
+        std::vector<char> data(bufDataSize);
+        std::vector<char> packed;
+        auto pData = &data.front();
+        size_t readBytes(0);
+        auto dataSize(bufDataSize);
+        auto needReadBytes(fileSize);
+        do {
+            if (bufDataSize > needReadBytes) {
+                dataSize = needReadBytes;
+            }
+            TraceSpan span("file read", "disk", "bytes", static_cast<int64_t>(dataSize));
+            ifs.read(pData, static_cast<int64_t>(dataSize));
+            span.end();
+            auto bytesRead = ifs.gcount();
+            if (bytesRead < 1) {
+                break;
+            }
+            int bytesSent = utils::send_payload(client, pData, static_cast<int>(dataSize), packed, wireBytes);
+            if (bytesSent < 0) {
+                return false;
+            }
+            rawBytes += dataSize;
+            readBytes += dataSize;
+            needReadBytes = fileSize - readBytes;
+        } while (needReadBytes > 0);
+    }
 
     int bytes = client.send_terminate();
 
@@ -792,18 +1056,18 @@ void TCPClientApp::sendBinFile(ConnectionInfo connectionInfo, const std::string
     auto rcv_bytes = f_rcv.get();
 
     std::cout << "Sent/Received " << client.get_bytes_sent() << "/" << client.get_bytes_received() << " bytes" << std::endl;
+    std::cout << utils::get_compression_msg(client, rawBytes, wireBytes);
+    std::cout << utils::get_latency_msg(client);
+    return client.get_error() == 0;
 }
 
 void TCPClientApp::sendHexFile(ConnectionInfo connectionInfo, const std::string &fileName,
                                const std::string &fileNameOut /*= ""*/)
 {
-    std::cout << __func__ << "(" << fileName << ") started.\n";
-    std::ifstream ifs(fileName, std::ios::binary);
-    if (!ifs) {
+    if (!std::ifstream(fileName, std::ios::binary)) {
         std::cerr << "File \"" << std::string(fileName) << "\" not found.\n";
         return;
     }
-
     TCPClient client;
     if (!client.initConnection(connectionInfo)) {
         std::cerr << "Init error\n";
@@ -812,6 +1076,19 @@ void TCPClientApp::sendHexFile(ConnectionInfo connectionInfo, const std::string
     if (!client.connect()) {
         return;
     }
+    sendHexFile(client, fileName, fileNameOut);
+}
+
+bool TCPClientApp::sendHexFile(TCPClient &client, const std::string &fileName,
+                               const std::string &fileNameOut /*= ""*/)
+{
+    std::cout << __func__ << "(" << fileName << ") started.\n";
+    Tracer::set_thread_name("sender");
+    std::ifstream ifs(fileName, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "File \"" << std::string(fileName) << "\" not found.\n";
+        return false;
+    }
     ifs >> std::hex;
 
     auto bufSize = static_cast<size_t>(client.get_connection_info().tcpBufSize_);
@@ -837,15 +1114,17 @@ void TCPClientApp::sendHexFile(ConnectionInfo connectionInfo, const std::string
         }
         bytesSent = client.send(pBlock, static_cast<int>(bufSize));
         if (bytesSent < 0) {
-            return;
+            return false;
         }
     }
 
     bytesSent = client.send_terminate();
     if (bytesSent < 0) {
-        return;
+        return false;
     }
     f_rcv.get();
+    std::cout << utils::get_latency_msg(client);
+    return client.get_error() == 0;
 }
 
 bool TCPClientApp::sendData(TCPClient &client, std::vector<uint64_t> &dataIn)
@@ -855,15 +1134,12 @@ bool TCPClientApp::sendData(TCPClient &client, std::vector<uint64_t> &dataIn)
 
     auto bufSize = static_cast<size_t>(client.get_connection_info().tcpBufSize_);
     auto bufDataSize(bufSize - 16);
-    std::vector<uint64_t> data(static_cast<size_t>(bufSize / 8));
-    auto pBlock = reinterpret_cast<char *>(&data[0]);
-    auto pData = reinterpret_cast<char *>(&data[2]);
     auto pDataIn = reinterpret_cast<char *>(&dataIn[0]);
     size_t readBytes(0);
     auto dataSize(bufDataSize);
-    data[0] = static_cast<uint64_t>(dataSize);
-    data[1] = DataTypes::data;
 
+    std::vector<char> packed;
+    uint64_t wireBytes(0);
     utils::Timing tm("Sending");
 
     size_t i(0);
@@ -871,10 +1147,8 @@ bool TCPClientApp::sendData(TCPClient &client, std::vector<uint64_t> &dataIn)
     do {
         if (bufDataSize > needReadBytes) {
             dataSize = needReadBytes;
-            data[0] = dataSize;
         }
-        memcpy(pData, pDataIn + readBytes, dataSize);
-        int bytesSent = client.send(pBlock, static_cast<int>(bufSize));
+        int bytesSent = utils::send_payload(client, pDataIn + readBytes, static_cast<int>(dataSize), packed, wireBytes);
         if (bytesSent < 0) {
             return false;
         }
@@ -884,20 +1158,108 @@ bool TCPClientApp::sendData(TCPClient &client, std::vector<uint64_t> &dataIn)
     } while (needReadBytes > 0);
 
     tm.outResultStr(client.get_bytes_sent());
+    std::cout << utils::get_compression_msg(client, dataInSize, wireBytes);
 
     int bytes = client.send_terminate();
 
     return true;
 }
 
+bool TCPClientApp::pingPong(TCPClient &client, const uint64_t count, const uint32_t rate, LatencyHistogram &rtt)
+{
+    std::cout << __func__ << "(" << count << " blocks, "
+              << (rate > 0 ? std::to_string(rate) + " blocks/s" : std::string("closed loop")) << ") started.\n";
+    const auto bufSize = client.get_connection_info().tcpBufSize_;
+    const auto nowNs = []() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch()).count());
+    };
+    uint64_t received(0);
+    uint64_t reordered(0);
+    uint64_t nextSeq(0);
+    // payload of block: sequence number and time of sending, ns
+    std::vector<uint64_t> rcvBuf(bufSize / sizeof(uint64_t));
+    const auto receiveEcho = [&](bool &isTerminate) {
+        const int bytes = client.receive_data(reinterpret_cast<char *>(&rcvBuf[0]), static_cast<int>(bufSize), isTerminate);
+        if (bytes < 0) {
+            return false;
+        }
+        if (!isTerminate && bytes >= int(2 * sizeof(uint64_t))) {
+            rtt.record(nowNs() - rcvBuf[1]);
+            reordered += rcvBuf[0] < nextSeq ? 1 : 0;
+            nextSeq = std::max(nextSeq, rcvBuf[0] + 1);
+            ++received;
+        }
+        return true;
+    };
+    const auto receiveAll = [&]() {
+        bool isTerminate(false);
+        while (!isTerminate) {
+            if (!receiveEcho(isTerminate)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    rtt.reset();
+    bool res(true);
+    uint64_t sendBuf[2];
+    const auto t_start = std::chrono::steady_clock::now();
+    if (0 == rate) {
+        for (uint64_t seq = 0; seq < count && res; ++seq) {
+            sendBuf[0] = seq;
+            sendBuf[1] = nowNs();
+            bool isTerminate(false);
+            res = client.send_block(reinterpret_cast<const char *>(sendBuf), sizeof(sendBuf)) >= 0 && receiveEcho(isTerminate);
+        }
+        res = res && client.send_terminate() >= 0 && receiveAll();
+    } else {
+        auto f_rcv = std::async(std::launch::async, receiveAll);
+        const uint64_t periodNs = 1000000000ull / rate;
+        const auto firstNs = nowNs();
+        for (uint64_t seq = 0; seq < count && res; ++seq) {
+            // the time of schedule is sent, so a late sending is counted in the round trip
+            const auto slotNs = firstNs + seq * periodNs;
+            // the sleep is inexact by tens of microseconds, the rest of wait is spinning
+            const uint64_t spinNs = 200000;
+            const auto now = nowNs();
+            if (slotNs > now + spinNs) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(slotNs - now - spinNs));
+            }
+            while (nowNs() < slotNs) {
+                std::this_thread::yield();
+            }
+            sendBuf[0] = seq;
+            sendBuf[1] = slotNs;
+            res = client.send_block(reinterpret_cast<const char *>(sendBuf), sizeof(sendBuf)) >= 0;
+        }
+        res = client.send_terminate() >= 0 && res;
+        res = f_rcv.get() && res;
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+
+    std::cout << "Round trip:                        " << rtt.summary() << "\n"
+              << "Blocks per second:                 " << (seconds > 0 ? double(received) / seconds : 0) << "\n";
+    if (received < count) {
+        std::cout << "Lost blocks:                       " << count - received << "\n";
+    }
+    if (reordered > 0) {
+        std::cout << "Reordered blocks:                  " << reordered << "\n";
+    }
+    std::cout << std::flush;
+    return res && received == count && client.get_error() == 0;
+}
+
 int TCPClientApp::send_exit(TCPClient &client)
 {
-    //if (client.getState() == ConnectionState::Connected && (client.get_bytes_sent() % client.get_connection_info().tcpBufSize_ > 0)) {
-    client.disconnect();
-    //}
-    //if (client.getState() != ConnectionState::Connected) {
-    client.connect();
-    //}
+    // the established connection is used, it is reconnected only after an error
+    if (client.getState() != ConnectionState::Connected || client.get_error() != 0) {
+        client.disconnect();
+        if (!client.connect()) {
+            return -1;
+        }
+    }
     auto blockSize = static_cast<int>(client.get_connection_info().tcpBufSize_);
     if (blockSize * client.get_connection_info().nSockets_ == client.send_terminate_exit()) {
         std::cout << "The send of terminate flag and exit flag is executed successfully\n";
@@ -911,6 +1273,7 @@ int TCPClientApp::send_exit(TCPClient &client)
 
 uint64_t TCPClientApp::receiveToDs8(TCPClient &client, const std::string &fileNameReceive/* = ""*/)
 {
+    Tracer::set_thread_name("receiver");
     auto bufSize = client.get_connection_info().tcpBufSize_;
     std::ofstream ofs;
     if (!fileNameReceive.empty()) {
@@ -941,6 +1304,7 @@ uint64_t TCPClientApp::receiveToDs8(TCPClient &client, const std::string &fileNa
             startRcv = false;
         }
         if (ofs.is_open()/* && data[1] == DataTypes::data*/) {
+            TraceSpan span("disk write", "disk", "bytes", bufSize);
             ofs.write(pDataChar, bufSize);
         }
         if ((DataTypes::service == data[1] && (ControlTags::terminate == data[2] || ControlTags::terminate == data[3]))) {
@@ -959,6 +1323,7 @@ uint64_t TCPClientApp::receiveToDs8(TCPClient &client, const std::string &fileNa
 
 uint64_t TCPClientApp::receiveToHex(TCPClient &client, const std::string &fileNameReceive/* = ""*/)
 {
+    Tracer::set_thread_name("receiver");
     std::ofstream ofs;
     if (!fileNameReceive.empty()) {
         ofs.open(fileNameReceive, std::ofstream::out | std::ios::binary);
@@ -981,6 +1346,7 @@ uint64_t TCPClientApp::receiveToHex(TCPClient &client, const std::string &fileNa
         }
         rcv_bytes += bytes;
         if (ofs.is_open() && DataTypes::data == data[1].w_64) {
+            TraceSpan span("disk write", "disk", "bytes", static_cast<int64_t>(data[0].w_64));
             auto data_size = (data[0].w_64 + 7) / 8;
             for (size_t j = 0; j < data_size; j++) {
                 ofs << std::setw(16) << std::setfill('0') << data[j + 2].w_64 << "\n";
@@ -1006,6 +1372,7 @@ uint64_t TCPClientApp::receiveToHex(TCPClient &client, const std::string &fileNa
 
 uint64_t TCPClientApp::receiveToBin(TCPClient &client, const std::string &fileNameReceive/* = ""*/)
 {
+    Tracer::set_thread_name("receiver");
     std::ofstream ofs;
     if (!fileNameReceive.empty()) {
         ofs.open(fileNameReceive, std::ofstream::out | std::ios::binary);
@@ -1019,6 +1386,8 @@ uint64_t TCPClientApp::receiveToBin(TCPClient &client, const std::string &fileNa
     std::vector<utils::DS8WORD> data(static_cast<size_t>(bufSize / 8));
     auto pChar = data[0].c_8;
     auto pDataChar = data[2].c_8;
+    // payload of compressed block after decompression
+    std::vector<char> unpacked(bufSize);
     auto exit(false);
     size_t rcv_bytes(0);
 
@@ -1030,7 +1399,19 @@ uint64_t TCPClientApp::receiveToBin(TCPClient &client, const std::string &fileNa
         }
         rcv_bytes += bytes;
         if (ofs.is_open() && DataTypes::data == data[1].w_64) {
+            TraceSpan span("disk write", "disk", "bytes", static_cast<int64_t>(data[0].w_64));
             ofs.write(pDataChar, data[0].w_64);
+        } else if (DataTypes::compressed == data[1].w_64) {
+            const int size = data[0].w_64 <= bufSize - 16
+                             ? compression::unpack(pDataChar, size_t(data[0].w_64), &unpacked.front(), unpacked.size()) : -1;
+            if (size < 0) {
+                std::cerr << "Error of decompression of block." << std::endl;
+                break;
+            }
+            if (ofs.is_open()) {
+                TraceSpan span("disk write", "disk", "bytes", size);
+                ofs.write(&unpacked.front(), size);
+            }
         }
         exit = exit || (DataTypes::service == data[1].w_64 && (ControlTags::terminate == data[2].w_64
                                                                || ControlTags::terminate == data[3].w_64));
@@ -38,7 +38,8 @@ public:
 private:
     static std::mutex outMutex_;
     std::string title_;
-    std::chrono::high_resolution_clock::time_point t_start_;
+    /// Start in ticks of instrument (TSC)
+    uint64_t t_start_;
     bool is_out_result_;
 };
 
@@ -103,8 +104,55 @@ bool file_ds8_to_hex(const std::string &fileName, const std::string &fileNameHex
 
 } //namespace convertors
 
+static std::unordered_map<std::string, IoMode> typesOfIoMode{
+    { "blocking", IoMode::Blocking },
+    { "epoll", IoMode::EventLoop },
+    { "io_uring", IoMode::IoUring },
+    { "threads", IoMode::Threaded },
+};
+
+static std::unordered_map<std::string, InstrumentMode> typesOfInstrument{
+    { "off", InstrumentMode::Off },
+    { "sampled", InstrumentMode::Sampled },
+    { "full", InstrumentMode::Full },
+};
+
+static std::unordered_map<std::string, CompressionCodec> typesOfCompression{
+    { "none", CompressionCodec::Uncompressed },
+    { "lz4", CompressionCodec::Lz4 },
+    { "zstd", CompressionCodec::Zstd },
+};
+
+static std::unordered_map<std::string, SchedulerType> typesOfScheduler{
+    { "rr", SchedulerType::RoundRobin },
+    { "least_loaded", SchedulerType::LeastLoaded },
+    { "weighted", SchedulerType::Weighted },
+};
+
+/// Name of value in the map of names, empty if it is not found
+template <typename T>
+std::string name_of(const std::unordered_map<std::string, T> &names, const T value)
+{
+    for (const auto &it : names) {
+        if (it.second == value) {
+            return it.first;
+        }
+    }
+    return "";
+}
+
 std::string get_send_speed_msg(TCPClient &client);
 std::string get_receive_speed_msg(TCPClient &client);
+/// Percentiles of latencies of every socket and of all sockets, empty if the operations are not timed
+std::string get_latency_msg(TCPClient &client);
+/**
+ * @brief Send the payload by TCPClient::send_block(), it is compressed by the codec of connection if it gets smaller
+ * @param packed - buffer of compression, it is resized if needed
+ * @param wireBytes - the size of sent payload is added
+ */
+int send_payload(TCPClient &client, const char *data, const int length, std::vector<char> &packed, uint64_t &wireBytes);
+/// Sizes of payloads before and after compression, empty if the blocks are not compressed
+std::string get_compression_msg(TCPClient &client, const uint64_t rawBytes, const uint64_t wireBytes);
 bool replace_substr(std::string &str, const std::string &from, const std::string &to);
 std::string str_to_upper(const std::string &strIn);
 
@@ -211,7 +259,21 @@ public:
     static void sendDS8File(ConnectionInfo connectionInfo, const std::string &fileName, const std::string &fileNameOut = "");
     static void sendBinFile(ConnectionInfo connectionInfo, const std::string &fileName, const std::string &fileNameOut = "");
     static void sendHexFile(ConnectionInfo connectionInfo, const std::string &fileName, const std::string &fileNameOut = "");
+    /// Transfers of file over the established connection, TCPClient::finish_transfer() is needed before next transfer
+    static bool sendDS8File(TCPClient &client, const std::string &fileName, const std::string &fileNameOut = "");
+    static bool sendBinFile(TCPClient &client, const std::string &fileName, const std::string &fileNameOut = "");
+    static bool sendHexFile(TCPClient &client, const std::string &fileName, const std::string &fileNameOut = "");
     static bool sendData(TCPClient &client, std::vector<uint64_t> &dataIn);
+    /**
+     * @brief Round trip of single blocks: every block carries the sequence number and the time of sending,
+     * the time is taken back from the echo of block. The terminate tag is sent after the last block.
+     * @param count - count of blocks
+     * @param rate - blocks per second, the echoes are received by other thread (latency under load);
+     * 0 - the next block is sent after the echo of previous one
+     * @param rtt - histogram of round trips, nanoseconds
+     * @return false if the sending/receiving is failed or a block is lost
+     */
+    static bool pingPong(TCPClient &client, const uint64_t count, const uint32_t rate, LatencyHistogram &rtt);
     static int send_exit(TCPClient &client);
     static uint64_t receiveToDs8(TCPClient &client, const std::string &fileNameReceive = "");
     static uint64_t receiveToBin(TCPClient &client, const std::string &fileNameReceive = "");
@@ -0,0 +1,177 @@
+#include "tcpcompress.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#ifdef TCPCLIENT_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef TCPCLIENT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+const uint64_t sizeMask = 0xFFFFFFFF;
+
+uint64_t codecWord(const CompressionCodec codec, const size_t length)
+{
+    return (uint64_t(codec) << 32) | (uint64_t(length) & sizeMask);
+}
+}  // namespace
+
+namespace compression {
+uint64_t available()
+{
+    uint64_t mask(0);
+#ifdef TCPCLIENT_HAVE_LZ4
+    mask |= bit(CompressionCodec::Lz4);
+#endif
+#ifdef TCPCLIENT_HAVE_ZSTD
+    mask |= bit(CompressionCodec::Zstd);
+#endif
+    return mask;
+}
+
+const char *name(const CompressionCodec codec)
+{
+    switch (codec) {
+    case CompressionCodec::Lz4:
+        return "lz4";
+    case CompressionCodec::Zstd:
+        return "zstd";
+    default:
+        return "none";
+    }
+}
+
+size_t pack(const CompressionCodec codec, const int level, const char *data, const size_t length, char *packed,
+            const size_t maxLength)
+{
+    // the payload must be smaller than the original data, the block is sent uncompressed otherwise
+    const size_t limit = std::min(maxLength, length);
+    if (limit <= headerSize + 1 || length > sizeMask) {
+        return 0;
+    }
+    // the compressed data goes after the word of codec and is shorter than the original data
+    const size_t outLength = limit - headerSize - 1;
+    size_t size(0);
+    switch (codec) {
+#ifdef TCPCLIENT_HAVE_LZ4
+    case CompressionCodec::Lz4: {
+        const int res = LZ4_compress_fast(data, packed + headerSize, static_cast<int>(length), static_cast<int>(outLength),
+                                          std::max(1, level));
+        size = res > 0 ? size_t(res) : 0;
+        break;
+    }
+#endif
+#ifdef TCPCLIENT_HAVE_ZSTD
+    case CompressionCodec::Zstd: {
+        // the context is reused by every thread, its creation costs more than compression of small block
+        thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> ctx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        const size_t res = ctx ? ZSTD_compressCCtx(ctx.get(), packed + headerSize, outLength, data, length, level) : 0;
+        size = ZSTD_isError(res) ? 0 : res;
+        break;
+    }
+#endif
+    default:
+        (void)level;
+        (void)data;
+        (void)outLength;
+        return 0;
+    }
+    if (0 == size) {
+        return 0;
+    }
+    const uint64_t word = codecWord(codec, length);
+    memcpy(packed, &word, sizeof(word));
+    return headerSize + size;
+}
+
+int unpack(const char *packed, const size_t length, char *data, const size_t maxLength)
+{
+    if (length < headerSize) {
+        return -1;
+    }
+    uint64_t word(0);
+    memcpy(&word, packed, sizeof(word));
+    const auto codec = static_cast<CompressionCodec>(word >> 32);
+    const size_t size = size_t(word & sizeMask);
+    if (size > maxLength) {
+        return -1;
+    }
+    const char *in = packed + headerSize;
+    const size_t inLength = length - headerSize;
+    switch (codec) {
+#ifdef TCPCLIENT_HAVE_LZ4
+    case CompressionCodec::Lz4: {
+        const int res = LZ4_decompress_safe(in, data, static_cast<int>(inLength), static_cast<int>(size));
+        return res == static_cast<int>(size) ? res : -1;
+    }
+#endif
+#ifdef TCPCLIENT_HAVE_ZSTD
+    case CompressionCodec::Zstd: {
+        thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx *)> ctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+        const size_t res = ctx ? ZSTD_decompressDCtx(ctx.get(), data, size, in, inLength) : 0;
+        return !ZSTD_isError(res) && res == size ? static_cast<int>(res) : -1;
+    }
+#endif
+    default:
+        (void)in;
+        (void)inLength;
+        (void)data;
+        return -1;
+    }
+}
+} // namespace compression
+
+CompressPool::CompressPool(size_t count)
+    : stop_(false)
+{
+    if (0 == count) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        threads_.emplace_back(&CompressPool::run, this);
+    }
+}
+
+CompressPool::~CompressPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void CompressPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+}
+
+void CompressPool::run()
+{
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() {
+                return stop_ || !jobs_.empty();
+            });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
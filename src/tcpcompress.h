@@ -0,0 +1,86 @@
+/** @file tcpcompress.h
+ * @brief Compression of payloads of blocks (DataTypes::compressed) and the pool of compressing threads
+ */
+#ifndef TCPCOMPRESS_H
+#define TCPCOMPRESS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Codec of payload of block, the server advertises the codecs as mask of bits (1 << codec)
+enum CompressionCodec : int {
+    Uncompressed = 0,
+    /// LZ4 (TCPCLIENT_HAVE_LZ4)
+    Lz4 = 1,
+    /// Zstandard (TCPCLIENT_HAVE_ZSTD)
+    Zstd = 2
+};
+
+/**
+ * @brief Every block is compressed independently, so the blocks stay self-contained and the sockets independent.
+ * @par Payload of compressed block: the word of codec (high 32 bits) and size of original data (low 32 bits),
+ * then the compressed data. The block is sent uncompressed if its data is not smaller after compression.
+ */
+namespace compression {
+/// Size of word of codec and original size in the payload
+const size_t headerSize = sizeof(uint64_t);
+
+/// Codecs of this build as mask of bits
+uint64_t available();
+/// Mask of bit of codec
+inline uint64_t bit(const CompressionCodec codec)
+{
+    return uint64_t(1) << codec;
+}
+const char *name(const CompressionCodec codec);
+/**
+ * @brief Compress data to the payload of compressed block
+ * @param level - level of Zstandard, acceleration of LZ4
+ * @return size of payload, 0 - the codec is not available or the payload is not smaller than maxLength
+ */
+size_t pack(const CompressionCodec codec, const int level, const char *data, const size_t length, char *packed,
+            const size_t maxLength);
+/**
+ * @brief Decompress the payload of compressed block
+ * @return size of original data, -1 - wrong payload or unknown codec
+ */
+int unpack(const char *packed, const size_t length, char *data, const size_t maxLength);
+} // namespace compression
+
+/**
+ * @class CompressPool
+ * @brief Threads which run the compression of blocks of send pipeline, the jobs are taken in order of submit
+ * and finished in any order, the sender waits for the flag of every block.
+ */
+class CompressPool
+{
+public:
+    /// count 0 - one thread per core
+    explicit CompressPool(size_t count);
+    ~CompressPool();
+    void submit(std::function<void()> job);
+    size_t size() const
+    {
+        return threads_.size();
+    }
+    CompressPool(const CompressPool &) = delete;
+    CompressPool &operator=(const CompressPool &) = delete;
+
+private:
+    void run();
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
+
+#endif // TCPCOMPRESS_H
@@ -0,0 +1,267 @@
+#include "tcpechoserver.h"
+
+#include <iostream>
+#include <thread>
+
+namespace {
+#ifdef MSG_NOSIGNAL
+const int sendFlags = MSG_NOSIGNAL;
+#else
+const int sendFlags = 0;
+#endif
+
+void closeSocket(const DS_SOCKET sock)
+{
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(static_cast<int>(sock));
+#endif
+}
+
+/// Receive exactly "length" bytes, false if the socket is closed or failed
+bool recvAll(const DS_SOCKET sock, char *data, const size_t length)
+{
+    size_t done(0);
+    while (done < length) {
+        const auto rBytes = ::recv(sock, data + done, static_cast<int>(length - done), 0);
+        if (rBytes <= 0) {
+            if (rBytes < 0 && EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        done += size_t(rBytes);
+    }
+    return true;
+}
+
+bool sendAll(const DS_SOCKET sock, const char *data, const size_t length)
+{
+    size_t done(0);
+    while (done < length) {
+        const auto sBytes = ::send(sock, data + done, static_cast<int>(length - done), sendFlags);
+        if (sBytes <= 0) {
+            if (sBytes < 0 && EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        done += size_t(sBytes);
+    }
+    return true;
+}
+
+std::string codecs_string(const uint64_t codecs)
+{
+    std::string res;
+    for (const auto codec : { CompressionCodec::Lz4, CompressionCodec::Zstd }) {
+        if (codecs & compression::bit(codec)) {
+            res += (res.empty() ? "" : ",") + std::string(compression::name(codec));
+        }
+    }
+    return res.empty() ? "none" : res;
+}
+
+bool isServiceTag(const std::vector<uint64_t> &block, const uint64_t tag)
+{
+    return DataTypes::service == block[1] && (tag == block[2] || tag == block[3]);
+}
+}  // namespace
+
+EchoServer::EchoServer(const EchoServerConfig &config)
+    : config_(config)
+    , listenSocket_(0)
+    , port_(config.port_)
+    , stop_(false)
+    , exit_(false)
+    , blocks_(0)
+    , nextSend_(std::chrono::steady_clock::now())
+{
+    // the header of block is 4 words, the socketconfig block is 8 words
+    config_.blockSize_ = std::max<uint32_t>(config_.blockSize_, 8 * sizeof(uint64_t));
+    config_.blockSize_ -= config_.blockSize_ % sizeof(uint64_t);
+}
+
+EchoServer::~EchoServer()
+{
+    stop();
+}
+
+bool EchoServer::listen()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    int iResult = WSAStartup(static_cast<uint16_t>(MAKEWORD(2, 2)), &wsaData);
+    if (iResult != 0) {
+        std::cerr << "WSAStartup failed with error: " << iResult << std::endl;
+        return false;
+    }
+#endif
+    listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (static_cast<int>(listenSocket_) < 0) {
+        std::cerr << errno << ": Error open socket of server." << std::endl;
+        listenSocket_ = 0;
+        return false;
+    }
+    int reuse(1);
+    setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config_.port_));
+    addr.sin_addr.s_addr = inet_addr(config_.address_.c_str());
+    if (bind(listenSocket_, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || ::listen(listenSocket_, std::max(4, int(config_.nSockets_))) != 0) {
+        std::cerr << errno << ": Error listen " << config_.address_ << ":" << config_.port_ << "." << std::endl;
+        closeSocket(listenSocket_);
+        listenSocket_ = 0;
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    if (0 == getsockname(listenSocket_, (struct sockaddr *)&addr, &len)) {
+        port_ = ntohs(addr.sin_port);
+    }
+    return true;
+}
+
+int EchoServer::run()
+{
+    if (0 == listenSocket_ && !listen()) {
+        return 1;
+    }
+    std::cout << "Echo server:                       " << config_.address_ << ":" << port_ << "\n"
+              << "Count of sockets:                  " << std::to_string(config_.nSockets_) << "\n"
+              << "Use duplex mode of socket:         " << (config_.isDuplexSockets_ ? "yes" : "no") << "\n"
+              << "TCP block size in bytes:           " << config_.blockSize_ << "\n"
+              << "Delay of every block:              " << config_.delayUs_ << " us\n"
+              << "Codecs:                            " << codecs_string(config_.codecs_) << "\n"
+              << "Bandwidth limit:                   ";
+    if (config_.bandwidthMbps_ > 0) {
+        std::cout << config_.bandwidthMbps_ << " Mbit/s" << std::endl;
+    } else {
+        std::cout << "no" << std::endl;
+    }
+
+    while (!stop_ && !exit_) {
+        std::vector<DS_SOCKET> sockets;
+        std::vector<uint64_t> block(config_.blockSize_ / sizeof(uint64_t), 0);
+        for (uint64_t id = 0; id < config_.nSockets_; ++id) {
+            const auto sock = ::accept(listenSocket_, nullptr, nullptr);
+            if (static_cast<int>(sock) < 0) {
+                if (!stop_) {
+                    std::cerr << errno << ": Error accept of socket." << std::endl;
+                }
+                for (const auto s : sockets) {
+                    closeSocket(s);
+                }
+                return stop_ ? 0 : 1;
+            }
+            int flag(1);
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&flag, sizeof(flag));
+            // socketconfig block: size of payload, type, tag, version, socket ID, block size, count of sockets, duplex
+            const uint64_t config[] = { 7 * sizeof(uint64_t), DataTypes::service, ControlTags::socketconfig,
+                                        Version::TcpIoBlock::gMinVersion, id, config_.blockSize_, config_.nSockets_,
+                                        config_.isDuplexSockets_ ? 1u : 0u };
+            std::fill(block.begin(), block.end(), 0);
+            std::copy(std::begin(config), std::end(config), block.begin());
+            if (block.size() > 8) {
+                block[8] = config_.codecs_;
+            }
+            if (!sendAll(sock, reinterpret_cast<const char *>(block.data()), config_.blockSize_)) {
+                std::cerr << errno << ": Error send of socketconfig block." << std::endl;
+                closeSocket(sock);
+                --id;
+                continue;
+            }
+            sockets.push_back(sock);
+        }
+        std::cout << "Connected " << sockets.size() << " sockets" << std::endl;
+        const bool isExit = !serve(sockets);
+        std::cout << "Disconnected, blocks sent back: " << get_blocks() << std::endl;
+        if (isExit || config_.once_) {
+            break;
+        }
+    }
+    if (listenSocket_ != 0) {
+        closeSocket(listenSocket_);
+        listenSocket_ = 0;
+    }
+    return 0;
+}
+
+void EchoServer::stop()
+{
+    stop_ = true;
+    if (listenSocket_ != 0) {
+        // accept() is interrupted by shutdown, the socket is closed by run()
+        shutdown(listenSocket_, 2);
+    }
+}
+
+bool EchoServer::serve(std::vector<DS_SOCKET> &sockets)
+{
+    std::vector<std::thread> lanes;
+    if (config_.isDuplexSockets_) {
+        for (const auto sock : sockets) {
+            lanes.emplace_back(&EchoServer::echo_lane, this, sock, sock);
+        }
+    } else {
+        const size_t half = sockets.size() / 2;
+        for (size_t i = 0; i < half; ++i) {
+            lanes.emplace_back(&EchoServer::echo_lane, this, sockets[i], sockets[i + half]);
+        }
+    }
+    for (auto &lane : lanes) {
+        lane.join();
+    }
+    for (const auto sock : sockets) {
+        closeSocket(sock);
+    }
+    sockets.clear();
+    return !exit_;
+}
+
+void EchoServer::echo_lane(const DS_SOCKET in, const DS_SOCKET out)
+{
+    std::vector<uint64_t> block(config_.blockSize_ / sizeof(uint64_t));
+    char *data = reinterpret_cast<char *>(block.data());
+    while (!stop_ && recvAll(in, data, config_.blockSize_)) {
+        if (config_.delayUs_ > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(config_.delayUs_));
+        }
+        pace(config_.blockSize_);
+        if (!sendAll(out, data, config_.blockSize_)) {
+            std::cerr << errno << ": Error send of block." << std::endl;
+            break;
+        }
+        blocks_.fetch_add(1, std::memory_order_relaxed);
+        if (isServiceTag(block, ControlTags::exit)) {
+            // every send lane of client gets the exit tag
+            exit_ = true;
+            break;
+        }
+    }
+    if (in != out) {
+        // the client does not wait on the receive socket after the end of send socket
+        shutdown(out, 2);
+    }
+}
+
+void EchoServer::pace(const size_t bytes)
+{
+    if (0 == config_.bandwidthMbps_) {
+        return;
+    }
+    std::chrono::steady_clock::time_point slot;
+    {
+        std::lock_guard<std::mutex> lock(paceMutex_);
+        const auto now = std::chrono::steady_clock::now();
+        if (nextSend_ < now) {
+            nextSend_ = now;
+        }
+        slot = nextSend_;
+        nextSend_ += std::chrono::nanoseconds(uint64_t(bytes) * 8000 / config_.bandwidthMbps_);
+    }
+    std::this_thread::sleep_until(slot);
+}
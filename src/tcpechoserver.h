@@ -0,0 +1,92 @@
+/** @file tcpechoserver.h
+ * @brief Loopback stand-in of tcp_io_block: the server of socketconfig handshake which sends the blocks back
+ */
+#ifndef TCPECHOSERVER_H
+#define TCPECHOSERVER_H
+
+#include "tcpclient.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** @struct EchoServerConfig
+ * @brief Parameters of EchoServer, they are sent to TCPClient in the socketconfig block
+ */
+struct EchoServerConfig {
+    /// Port of server, 0 - any free port (EchoServer::port())
+    int port_;
+    /// Address of listening, loopback by default
+    std::string address_;
+    uint32_t blockSize_;
+    uint8_t nSockets_;
+    bool isDuplexSockets_;
+    /// Pause of processing of every block before it is sent back, microseconds
+    uint32_t delayUs_;
+    /// Limit of sending of all sockets together, Mbit/s (0 - no limit)
+    uint32_t bandwidthMbps_;
+    /// Serve one connection and return (the exit tag finishes the server always)
+    bool once_;
+    /// Codecs advertised after the socketconfig words (mask of compression::bit()), the compressed blocks
+    /// are sent back as they are, so every codec is accepted by default
+    uint64_t codecs_;
+    //------------------------------------------------
+    EchoServerConfig() : port_(12340), address_("127.0.0.1"), blockSize_(4096), nSockets_(1), isDuplexSockets_(true),
+        delayUs_(0), bandwidthMbps_(0), once_(false),
+        codecs_(compression::bit(CompressionCodec::Lz4) | compression::bit(CompressionCodec::Zstd)) {}
+};
+
+/**
+ * @class EchoServer
+ * @brief Accepts the sockets of one TCPClient connection, sends the socketconfig block to every socket
+ * (version, socket ID, block size, count of sockets, duplex flag, then the mask of codecs) and sends every received block back:
+ * on the same socket in duplex mode, on the pair of socket (ID + nSockets/2) otherwise.
+ * @par The terminate tag is sent back as every block, the connection is used for the next transfer.
+ * The exit tag is sent back and finishes the server. The connection is finished if the client closes any socket.
+ */
+class EchoServer
+{
+public:
+    explicit EchoServer(const EchoServerConfig &config);
+    ~EchoServer();
+    /// Open the listening socket
+    bool listen();
+    /// Port of listening socket (the chosen one if EchoServerConfig::port_ is 0)
+    int port() const
+    {
+        return port_;
+    }
+    /**
+     * @brief Serve the connections until the exit tag, stop() or the end of first one (EchoServerConfig::once_)
+     * @return 0 - exit tag or stop, other - error
+     */
+    int run();
+    /// Finish run() from other thread
+    void stop();
+    /// Blocks which are sent back since start
+    uint64_t get_blocks() const
+    {
+        return blocks_.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// Serve the sockets of one connection, false if the exit tag is received
+    bool serve(std::vector<DS_SOCKET> &sockets);
+    /// Receive blocks from "in" socket and send them back to "out" socket
+    void echo_lane(const DS_SOCKET in, const DS_SOCKET out);
+    /// Wait the slot of sending of block of "bytes" bytes within the limit of bandwidth
+    void pace(const size_t bytes);
+
+    EchoServerConfig config_;
+    DS_SOCKET listenSocket_;
+    int port_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> exit_;
+    std::atomic<uint64_t> blocks_;
+    std::mutex paceMutex_;
+    std::chrono::steady_clock::time_point nextSend_;
+};
+
+#endif // TCPECHOSERVER_H
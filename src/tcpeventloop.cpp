@@ -0,0 +1,275 @@
+#include "tcpeventloop.h"
+#include "tcptrace.h"
+
+#include <iostream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <fcntl.h>
+#endif
+
+EventLoopTransport::EventLoopTransport(const std::vector<DS_SOCKET> &sockets, const bool isReceive,
+                                       const uint32_t blockSize, const uint32_t queueDepth, const int timeOutSec)
+    : lanes_(sockets.size())
+    , isReceive_(isReceive)
+    , capacity_(static_cast<size_t>(blockSize) * std::max<uint32_t>(1, queueDepth))
+    , timeOutMs_(timeOutSec > 0 ? timeOutSec * 1000 : -1)
+    , epfd_(-1)
+{
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        lanes_[i].sock_ = sockets[i];
+    }
+}
+
+#ifdef __linux__
+
+EventLoopTransport::~EventLoopTransport()
+{
+    if (epfd_ >= 0) {
+        close(epfd_);
+    }
+}
+
+bool EventLoopTransport::init()
+{
+    epfd_ = epoll_create1(0);
+    if (epfd_ < 0) {
+        std::cerr << errno << ": Error create epoll." << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        auto &lane = lanes_[i];
+        const int fd = static_cast<int>(lane.sock_);
+        lane.buf_.resize(capacity_);
+        const int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            std::cerr << errno << ": Error set non-blocking mode of socket." << std::endl;
+            return false;
+        }
+        // Edge triggered: the ready_ flag is cleared only when the socket returns EAGAIN
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = (isReceive_ ? EPOLLIN : EPOLLOUT) | EPOLLET;
+        ev.data.u64 = i;
+        if (epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            std::cerr << errno << ": Error add socket to epoll." << std::endl;
+            return false;
+        }
+        lane.ready_ = true;
+    }
+    return true;
+}
+
+void EventLoopTransport::write_lane(Lane &lane)
+{
+    while (lane.ready_ && lane.size_ > 0 && 0 == lane.err_) {
+        const size_t chunk = std::min(lane.size_, capacity_ - lane.head_);
+        TraceSpan span("send", "net", "fd", static_cast<int64_t>(lane.sock_));
+        auto bytes = ::send(static_cast<int>(lane.sock_), &lane.buf_[lane.head_], chunk, MSG_NOSIGNAL);
+        span.end();
+        if (bytes < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                lane.ready_ = false;
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            lane.err_ = errno;
+            lane.ready_ = false;
+            break;
+        }
+        lane.head_ = (lane.head_ + static_cast<size_t>(bytes)) % capacity_;
+        lane.size_ -= static_cast<size_t>(bytes);
+    }
+    if (0 == lane.size_) {
+        lane.head_ = 0;
+    }
+}
+
+void EventLoopTransport::read_lane(Lane &lane)
+{
+    while (lane.ready_ && lane.size_ < capacity_ && 0 == lane.err_) {
+        const size_t tail = (lane.head_ + lane.size_) % capacity_;
+        const size_t chunk = std::min(capacity_ - lane.size_, capacity_ - tail);
+        TraceSpan span("recv", "net", "fd", static_cast<int64_t>(lane.sock_));
+        auto bytes = ::recv(static_cast<int>(lane.sock_), &lane.buf_[tail], chunk, 0);
+        span.end();
+        if (bytes < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                lane.ready_ = false;
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            lane.err_ = errno;
+            lane.ready_ = false;
+            break;
+        }
+        if (0 == bytes) {
+            // connection is closed by server, the queued data of lane is still received
+            lane.err_ = ECONNRESET;
+            lane.ready_ = false;
+            break;
+        }
+        lane.size_ += static_cast<size_t>(bytes);
+    }
+}
+
+void EventLoopTransport::service()
+{
+    for (auto &lane : lanes_) {
+        if (isReceive_) {
+            read_lane(lane);
+        } else {
+            write_lane(lane);
+        }
+    }
+}
+
+int EventLoopTransport::lane_error(const Lane &lane) const
+{
+    errno = lane.err_;
+    return -1;
+}
+
+bool EventLoopTransport::pump()
+{
+    struct epoll_event events[64];
+    const int maxEvents = static_cast<int>(std::min<size_t>(64, lanes_.size()));
+    int count(0);
+    TraceSpan span("epoll_wait", "net");
+    do {
+        count = epoll_wait(epfd_, events, maxEvents, timeOutMs_);
+    } while (count < 0 && errno == EINTR);
+    span.end();
+    if (count < 0) {
+        return false;
+    }
+    if (0 == count) {
+        errno = ETIMEDOUT;
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        lanes_[static_cast<size_t>(events[i].data.u64)].ready_ = true;
+    }
+    service();
+    return true;
+}
+
+int EventLoopTransport::sendv(size_t lane_idx, const DataPart *parts, size_t count)
+{
+    auto &lane = lanes_[lane_idx];
+    size_t total(0);
+    for (size_t i = 0; i < count; ++i) {
+        const auto &part = parts[i];
+        size_t queued(0);
+        while (queued < part.length_) {
+            if (lane.err_ != 0) {
+                return lane_error(lane);
+            }
+            if (lane.size_ == capacity_ && !pump()) {
+                return -1;
+            }
+            if (lane.size_ == capacity_) {
+                continue;
+            }
+            const size_t tail = (lane.head_ + lane.size_) % capacity_;
+            const size_t chunk = std::min(part.length_ - queued,
+                                          std::min(capacity_ - lane.size_, capacity_ - tail));
+            if (part.data_) {
+                memcpy(&lane.buf_[tail], part.data_ + queued, chunk);
+            } else {
+                memset(&lane.buf_[tail], 0, chunk);
+            }
+            lane.size_ += chunk;
+            queued += chunk;
+            if (lane.size_ == capacity_) {
+                service();
+            }
+        }
+        total += part.length_;
+    }
+    service();
+    if (lane.err_ != 0) {
+        return lane_error(lane);
+    }
+    return static_cast<int>(total);
+}
+
+int EventLoopTransport::receive(size_t lane_idx, char *data, int length)
+{
+    auto &lane = lanes_[lane_idx];
+    size_t received(0);
+    while (received < static_cast<size_t>(length)) {
+        if (0 == lane.size_) {
+            // read all ready lanes, so the other sockets are drained while this one is waited
+            service();
+            if (0 == lane.size_ && lane.err_ != 0) {
+                // only the empty closed lane fails, the other lanes keep their blocks
+                return lane_error(lane);
+            }
+            if (0 == lane.size_ && !pump()) {
+                return -1;
+            }
+            continue;
+        }
+        const size_t chunk = std::min(static_cast<size_t>(length) - received,
+                                      std::min(lane.size_, capacity_ - lane.head_));
+        memcpy(data + received, &lane.buf_[lane.head_], chunk);
+        lane.head_ = (lane.head_ + chunk) % capacity_;
+        lane.size_ -= chunk;
+        received += chunk;
+    }
+    return length;
+}
+
+bool EventLoopTransport::flush()
+{
+    for (;;) {
+        service();
+        bool pending(false);
+        for (const auto &lane : lanes_) {
+            if (lane.size_ > 0 && lane.err_ != 0) {
+                // the queued data of failed lane is lost
+                lane_error(lane);
+                return false;
+            }
+            pending = pending || lane.size_ > 0;
+        }
+        if (!pending) {
+            return true;
+        }
+        if (!pump()) {
+            return false;
+        }
+    }
+}
+
+#else // not __linux__
+
+EventLoopTransport::~EventLoopTransport() {}
+
+bool EventLoopTransport::init()
+{
+    return false;
+}
+
+int EventLoopTransport::sendv(size_t, const DataPart *, size_t)
+{
+    return -1;
+}
+
+int EventLoopTransport::receive(size_t, char *, int)
+{
+    return -1;
+}
+
+bool EventLoopTransport::flush()
+{
+    return false;
+}
+
+#endif // __linux__
@@ -0,0 +1,80 @@
+/** @file tcpeventloop.h
+ * @brief Event loop (non-blocking sockets + epoll) engine for TCPClient
+ */
+#ifndef TCPEVENTLOOP_H
+#define TCPEVENTLOOP_H
+
+#include "tcptransport.h"
+
+/**
+ * @class EventLoopTransport
+ * @brief Every socket has its own queue and is serviced when it is ready, so a slow
+ * socket does not stall the other sockets of the session.
+ * @par Data is queued to the lane which is chosen by TCPClient (round-robin), so the
+ * order of blocks on every socket is the same as for the blocking mode. While waiting
+ * for one lane the loop keeps writing (reading) all other ready lanes.
+ */
+class EventLoopTransport : public BlockTransport
+{
+public:
+    /**
+     * @brief Constructor
+     * @param sockets - sockets of one direction
+     * @param isReceive - true for receive sockets, false for send sockets
+     * @param blockSize - size of TCP block in bytes
+     * @param queueDepth - size of queue of every socket in blocks
+     * @param timeOutSec - time out of waiting of socket, seconds (0 - infinite)
+     */
+    EventLoopTransport(const std::vector<DS_SOCKET> &sockets, const bool isReceive, const uint32_t blockSize,
+                       const uint32_t queueDepth, const int timeOutSec);
+    virtual ~EventLoopTransport();
+    /**
+     * @brief Create epoll instance and turn sockets to non-blocking mode
+     * @return false if event loop is not supported on this platform
+     */
+    bool init();
+    virtual int sendv(size_t lane, const DataPart *parts, size_t count);
+    virtual int receive(size_t lane, char *data, int length);
+    virtual bool flush();
+    virtual size_t queued(size_t lane) const
+    {
+        return lanes_[lane].size_;
+    }
+    virtual const char *name() const
+    {
+        return "epoll";
+    }
+
+private:
+    /// Queue of one socket
+    struct Lane {
+        DS_SOCKET sock_;
+        /// Ring buffer of data
+        std::vector<char> buf_;
+        /// Offset of first queued byte
+        size_t head_;
+        /// Count of queued bytes
+        size_t size_;
+        /// Socket can be written (read) without blocking
+        bool ready_;
+        /// errno of failure of socket (ECONNRESET if it is closed by server), 0 - socket is open
+        int err_;
+        Lane() : sock_(0), head_(0), size_(0), ready_(false), err_(0) {}
+    };
+    /// Write (read) all ready lanes without waiting, the failed socket closes only its own lane
+    void service();
+    /// Wait of events and service all ready lanes
+    bool pump();
+    void write_lane(Lane &lane);
+    void read_lane(Lane &lane);
+    /// Set errno of the failed lane, always -1
+    int lane_error(const Lane &lane) const;
+
+    std::vector<Lane> lanes_;
+    bool isReceive_;
+    size_t capacity_;
+    int timeOutMs_;
+    int epfd_;
+};
+
+#endif // TCPEVENTLOOP_H
@@ -0,0 +1,122 @@
+#include "tcphistogram.h"
+
+#include <sstream>
+#include <iomanip>
+
+namespace {
+/// Percentiles of summary
+const double summaryPercents[] = { 50, 90, 99, 99.9 };
+
+std::string durationToString(const uint64_t ns)
+{
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (ns < 1000) {
+        ss << ns << "ns";
+    } else if (ns < 1000000) {
+        ss << double(ns) / 1000 << "us";
+    } else if (ns < 1000000000) {
+        ss << double(ns) / 1000000 << "ms";
+    } else {
+        ss << double(ns) / 1000000000 << "s";
+    }
+    return ss.str();
+}
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+size_t LatencyHistogram::index(uint64_t ns)
+{
+    if (ns < subCount) {
+        return static_cast<size_t>(ns);
+    }
+    const uint64_t maxValue = (uint64_t(1) << maxBits) - 1;
+    if (ns > maxValue) {
+        ns = maxValue;
+    }
+    unsigned msb(0);
+    for (auto v = ns; v > 1; v >>= 1) {
+        ++msb;
+    }
+    const unsigned shift = msb - subBits;
+    return static_cast<size_t>(shift * subCount + (ns >> shift));
+}
+
+uint64_t LatencyHistogram::value_of(const size_t idx)
+{
+    if (idx < 2 * subCount) {
+        return idx;
+    }
+    const unsigned shift = static_cast<unsigned>(idx / subCount - 1);
+    return (uint64_t(idx - shift * subCount) << shift) + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (size_t i = 0; i < bucketCount; ++i) {
+        const auto n = other.buckets_[i].load(std::memory_order_relaxed);
+        if (n > 0) {
+            buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    if (other.max() > max()) {
+        max_.store(other.max(), std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+    uint64_t n(0);
+    for (const auto &bucket : buckets_) {
+        n += bucket.load(std::memory_order_relaxed);
+    }
+    return n;
+}
+
+uint64_t LatencyHistogram::percentile(const double percent) const
+{
+    const auto total = count();
+    if (0 == total) {
+        return 0;
+    }
+    // rank of value, at least the first one
+    auto rank = static_cast<uint64_t>(percent / 100 * double(total) + 0.5);
+    rank = rank < 1 ? 1 : (rank > total ? total : rank);
+    uint64_t n(0);
+    for (size_t i = 0; i < bucketCount; ++i) {
+        n += buckets_[i].load(std::memory_order_relaxed);
+        if (n >= rank) {
+            // the value is not above the max which is known exactly
+            const auto value = value_of(i);
+            return value < max() ? value : max();
+        }
+    }
+    return max();
+}
+
+std::string LatencyHistogram::summary() const
+{
+    const auto total = count();
+    std::string res("n=" + std::to_string(total));
+    if (0 == total) {
+        return res;
+    }
+    for (const auto percent : summaryPercents) {
+        std::ostringstream ss;
+        ss << percent;
+        res += " p" + ss.str() + "=" + durationToString(percentile(percent));
+    }
+    return res + " max=" + durationToString(max());
+}
@@ -0,0 +1,60 @@
+/** @file tcphistogram.h
+ * @brief Histogram of latencies of send/receive operations
+ */
+#ifndef TCPHISTOGRAM_H
+#define TCPHISTOGRAM_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @class LatencyHistogram
+ * @brief Log-linear histogram of nanoseconds (as HdrHistogram): every power of two is split
+ * to subCount buckets, so the error of value is less than 1/subCount (3%) in the range from 1 ns to 73 min.
+ * @par One thread records the values, any thread reads them. The histograms of several sockets
+ * are merged to one by merge().
+ */
+class LatencyHistogram
+{
+public:
+    static const unsigned subBits = 5;
+    static const size_t subCount = size_t(1) << subBits;
+    /// Values of 2^maxBits ns and more are counted in the last bucket
+    static const unsigned maxBits = 42;
+    static const size_t bucketCount = (maxBits - subBits + 1) * subCount;
+
+    LatencyHistogram();
+    /// Count one value, only one thread may call it
+    void record(const uint64_t ns)
+    {
+        auto &bucket = buckets_[index(ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ns > max_.load(std::memory_order_relaxed)) {
+            max_.store(ns, std::memory_order_relaxed);
+        }
+    }
+    /// Add the counts of other histogram
+    void merge(const LatencyHistogram &other);
+    void reset();
+    uint64_t count() const;
+    uint64_t max() const
+    {
+        return max_.load(std::memory_order_relaxed);
+    }
+    /// Value of percentile (0..100), the highest value of its bucket
+    uint64_t percentile(const double percent) const;
+    /// "n=<count> p50=... p90=... p99=... p99.9=... max=...", "n=0" if empty
+    std::string summary() const;
+
+private:
+    static size_t index(const uint64_t ns);
+    /// The highest value of bucket
+    static uint64_t value_of(const size_t idx);
+
+    std::atomic<uint64_t> buckets_[bucketCount];
+    std::atomic<uint64_t> max_;
+};
+
+#endif // TCPHISTOGRAM_H
@@ -0,0 +1,33 @@
+#include "tcpinstrument.h"
+
+#include <thread>
+
+namespace {
+/// Time of measuring of TSC against steady clock
+const auto calibrationTime = std::chrono::milliseconds(5);
+
+double calibrate()
+{
+#ifdef TCPCLIENT_HAVE_TSC
+    const auto c1 = std::chrono::steady_clock::now();
+    const auto t1 = instrument::ticks();
+    std::this_thread::sleep_for(calibrationTime);
+    const auto t2 = instrument::ticks();
+    const auto c2 = std::chrono::steady_clock::now();
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(c2 - c1).count();
+    return t2 > t1 ? double(ns) / double(t2 - t1) : 1.0;
+#else
+    return 1.0;
+#endif
+}
+}  // namespace
+
+namespace instrument {
+
+double ns_per_tick()
+{
+    static const double nsPerTick = calibrate();
+    return nsPerTick;
+}
+
+} // namespace instrument
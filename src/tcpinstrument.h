@@ -0,0 +1,126 @@
+/** @file tcpinstrument.h
+ * @brief Timing of send/receive operations of TCPClient
+ */
+#ifndef TCPINSTRUMENT_H
+#define TCPINSTRUMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TCPCLIENT_HAVE_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+/// Mode of timing of operations. The timing is off always if TCPCLIENT_NO_INSTRUMENT is defined
+enum InstrumentMode : int {
+    /// The operations are not timed, the speed of network is not reported
+    Off = 0,
+    /// One of every N operations is timed, its time is counted N times
+    Sampled = 1,
+    /// Every operation is timed
+    Full = 2
+};
+
+namespace instrument {
+
+/// Timestamp in ticks: TSC on x86, nanoseconds of steady clock on other CPUs
+inline uint64_t ticks()
+{
+#ifdef TCPCLIENT_HAVE_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/// Nanoseconds per tick, TSC is measured against steady clock once, at the first call
+double ns_per_tick();
+
+inline uint64_t to_ns(const uint64_t ticks)
+{
+#ifdef TCPCLIENT_HAVE_TSC
+    return static_cast<uint64_t>(double(ticks) * ns_per_tick());
+#else
+    return ticks;
+#endif
+}
+
+} // namespace instrument
+
+/**
+ * @class Instrument
+ * @brief Timer of operations of one direction.
+ * @code
+ * const auto t0 = instrument.start();
+ * ... operation ...
+ * counters.add_time(instrument.estimate(instrument.elapsed(t0)));
+ * @endcode
+ * start() returns 0 if the operation is not timed, then elapsed() is 0 without reading of clock.
+ */
+class Instrument
+{
+public:
+    Instrument() : mode_(InstrumentMode::Full), sampleRate_(1), count_(0) {}
+    void configure(const InstrumentMode mode, const uint32_t sampleRate)
+    {
+        mode_ = mode;
+        sampleRate_ = InstrumentMode::Sampled == mode && sampleRate > 1 ? sampleRate : 1;
+        count_.store(0, std::memory_order_relaxed);
+        if (InstrumentMode::Off != mode) {
+            // the calibration is done before the first operation
+            instrument::ns_per_tick();
+        }
+    }
+    InstrumentMode mode() const
+    {
+#ifdef TCPCLIENT_NO_INSTRUMENT
+        return InstrumentMode::Off;
+#else
+        return mode_;
+#endif
+    }
+    uint32_t sample_rate() const
+    {
+        return sampleRate_;
+    }
+    /// Timestamp of start of operation, 0 if the operation is not timed
+    uint64_t start()
+    {
+#ifdef TCPCLIENT_NO_INSTRUMENT
+        return 0;
+#else
+        if (InstrumentMode::Off == mode_) {
+            return 0;
+        }
+        if (sampleRate_ > 1 && count_.fetch_add(1, std::memory_order_relaxed) % sampleRate_ != 0) {
+            return 0;
+        }
+        const auto t = instrument::ticks();
+        return t != 0 ? t : 1;
+#endif
+    }
+    /// Time of operation since start(), nanoseconds (0 if it is not timed)
+    uint64_t elapsed(const uint64_t t0) const
+    {
+        return 0 == t0 ? 0 : instrument::to_ns(instrument::ticks() - t0);
+    }
+    /// Time of all operations which are represented by the timed one
+    uint64_t estimate(const uint64_t ns) const
+    {
+        return ns * sampleRate_;
+    }
+
+private:
+    InstrumentMode mode_;
+    uint32_t sampleRate_;
+    std::atomic<uint32_t> count_;
+};
+
+#endif // TCPINSTRUMENT_H
@@ -0,0 +1,458 @@
+#include "tcpiouring.h"
+#include "tcptrace.h"
+
+#include <iostream>
+#include <algorithm>
+
+#ifdef TCPCLIENT_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace {
+const uint64_t timeoutTag = ~uint64_t(0);
+const uint64_t cancelTag = ~uint64_t(0) - 1;
+
+int io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+int io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nrArgs)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+}  // namespace
+#endif // TCPCLIENT_HAVE_IO_URING
+
+IoUringTransport::IoUringTransport(const std::vector<DS_SOCKET> &sockets, const bool isReceive,
+                                   const uint32_t blockSize, const uint32_t queueDepth, const int timeOutSec)
+    : lanes_(sockets.size())
+    , isReceive_(isReceive)
+    , capacity_(static_cast<size_t>(blockSize) * std::max<uint32_t>(1, queueDepth))
+    , timeOutSec_(timeOutSec)
+    , isFixed_(false)
+    , batch_(0)
+    , toSubmit_(0)
+    , timeoutExpired_(false)
+    , memory_(nullptr)
+    , ringFd_(-1)
+    , sqPtr_(nullptr)
+    , cqPtr_(nullptr)
+    , sqSize_(0)
+    , cqSize_(0)
+    , sqes_(nullptr)
+    , sqesSize_(0)
+    , sqHead_(nullptr)
+    , sqTail_(nullptr)
+    , sqMask_(nullptr)
+    , sqArray_(nullptr)
+    , cqHead_(nullptr)
+    , cqTail_(nullptr)
+    , cqMask_(nullptr)
+    , cqes_(nullptr)
+{
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        lanes_[i].sock_ = sockets[i];
+    }
+}
+
+#ifdef TCPCLIENT_HAVE_IO_URING
+
+IoUringTransport::~IoUringTransport()
+{
+    if (ringFd_ >= 0) {
+        // The kernel must not touch the buffers after they are freed
+        bool inFlight(false);
+        for (size_t i = 0; i < lanes_.size(); ++i) {
+            if (!lanes_[i].inFlight_) {
+                continue;
+            }
+            inFlight = true;
+            const unsigned tail = *sqTail_;
+            auto sqe = static_cast<struct io_uring_sqe *>(sqes_) + (tail & *sqMask_);
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = i;
+            sqe->user_data = cancelTag;
+            sqArray_[tail & *sqMask_] = tail & *sqMask_;
+            __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+            ++toSubmit_;
+        }
+        timeOutSec_ = 1;
+        for (auto attempt = 0; inFlight && attempt < 8; ++attempt) {
+            submit(true);
+            inFlight = std::any_of(lanes_.begin(), lanes_.end(), [](const Lane & lane) {
+                return lane.inFlight_;
+            });
+        }
+        munmap(sqes_, sqesSize_);
+        if (cqPtr_ != sqPtr_) {
+            munmap(cqPtr_, cqSize_);
+        }
+        munmap(sqPtr_, sqSize_);
+        close(ringFd_);
+    }
+    free(memory_);
+}
+
+bool IoUringTransport::init()
+{
+    if (lanes_.empty()) {
+        return false;
+    }
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // one operation per lane, timeouts and cancels
+    ringFd_ = io_uring_setup(static_cast<unsigned>(2 * lanes_.size() + 4), &params);
+    if (ringFd_ < 0) {
+        std::cerr << errno << ": Error create io_uring." << std::endl;
+        return false;
+    }
+    sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+    }
+    sqPtr_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == sqPtr_) {
+        std::cerr << errno << ": Error map io_uring." << std::endl;
+        close(ringFd_);
+        ringFd_ = -1;
+        return false;
+    }
+    cqPtr_ = singleMmap ? sqPtr_ : mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                                        IORING_OFF_CQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if (MAP_FAILED == cqPtr_ || MAP_FAILED == sqes_) {
+        std::cerr << errno << ": Error map io_uring." << std::endl;
+        if (MAP_FAILED != sqes_) {
+            munmap(sqes_, sqesSize_);
+        }
+        if (MAP_FAILED != cqPtr_ && cqPtr_ != sqPtr_) {
+            munmap(cqPtr_, cqSize_);
+        }
+        munmap(sqPtr_, sqSize_);
+        close(ringFd_);
+        ringFd_ = -1;
+        return false;
+    }
+    auto sq = static_cast<char *>(sqPtr_);
+    auto cq = static_cast<char *>(cqPtr_);
+    sqHead_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cqHead_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+
+    void *memory(nullptr);
+    if (0 != posix_memalign(&memory, 4096, capacity_ * lanes_.size())) {
+        std::cerr << "Error allocate buffers of io_uring." << std::endl;
+        return false;
+    }
+    memory_ = static_cast<char *>(memory);
+    std::vector<struct iovec> iov(lanes_.size());
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        lanes_[i].buf_ = memory_ + i * capacity_;
+        iov[i].iov_base = lanes_[i].buf_;
+        iov[i].iov_len = capacity_;
+    }
+    isFixed_ = 0 == io_uring_register(ringFd_, IORING_REGISTER_BUFFERS, &iov[0], static_cast<unsigned>(iov.size()));
+    if (!isFixed_) {
+        std::cerr << errno << ": Buffers of io_uring are not registered (RLIMIT_MEMLOCK?)." << std::endl;
+    }
+    return true;
+}
+
+bool IoUringTransport::prepare(const size_t idx)
+{
+    auto &lane = lanes_[idx];
+    if (lane.inFlight_ || lane.err_ != 0) {
+        return false;
+    }
+    size_t offset(lane.head_);
+    size_t chunk(0);
+    if (isReceive_) {
+        offset = (lane.head_ + lane.size_) % capacity_;
+        chunk = std::min(capacity_ - lane.size_, capacity_ - offset);
+    } else {
+        chunk = std::min(lane.size_, capacity_ - lane.head_);
+    }
+    if (0 == chunk) {
+        return false;
+    }
+    const unsigned tail = *sqTail_;
+    const unsigned idxSqe = tail & *sqMask_;
+    auto sqe = static_cast<struct io_uring_sqe *>(sqes_) + idxSqe;
+    memset(sqe, 0, sizeof(*sqe));
+    if (isReceive_) {
+        sqe->opcode = isFixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    } else {
+        sqe->opcode = isFixed_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    }
+    sqe->fd = static_cast<int>(lane.sock_);
+    sqe->addr = reinterpret_cast<uint64_t>(lane.buf_ + offset);
+    sqe->len = static_cast<uint32_t>(chunk);
+    if (isFixed_) {
+        sqe->buf_index = static_cast<uint16_t>(idx);
+    }
+    sqe->user_data = idx;
+    sqArray_[idxSqe] = idxSqe;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    lane.inFlight_ = true;
+    ++toSubmit_;
+    return true;
+}
+
+void IoUringTransport::reap()
+{
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const auto cqe = static_cast<struct io_uring_cqe *>(cqes_) + (head & *cqMask_);
+        if (timeoutTag == cqe->user_data) {
+            timeoutExpired_ = timeoutExpired_ || -ETIME == cqe->res;
+            continue;
+        }
+        if (cancelTag == cqe->user_data) {
+            continue;
+        }
+        auto &lane = lanes_[static_cast<size_t>(cqe->user_data)];
+        lane.inFlight_ = false;
+        if (-ECANCELED == cqe->res) {
+            // the request is canceled by exit of the thread which has submitted it
+            // (e.g. other thread of the previous transfer), it is submitted again
+            continue;
+        }
+        if (cqe->res < 0) {
+            lane.err_ = -cqe->res;
+        } else if (isReceive_) {
+            if (0 == cqe->res) {
+                // connection is closed by server, the queued data of lane is still received
+                lane.err_ = ECONNRESET;
+            }
+            lane.size_ += static_cast<size_t>(cqe->res);
+        } else {
+            lane.head_ = (lane.head_ + static_cast<size_t>(cqe->res)) % capacity_;
+            lane.size_ -= static_cast<size_t>(cqe->res);
+            if (0 == lane.size_) {
+                lane.head_ = 0;
+            }
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+int IoUringTransport::lane_error(const Lane &lane) const
+{
+    errno = lane.err_;
+    return -1;
+}
+
+bool IoUringTransport::submit(const bool wait)
+{
+    bool inFlight(false);
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+        prepare(i);
+        inFlight = inFlight || lanes_[i].inFlight_;
+    }
+    if (wait && !inFlight) {
+        return false;
+    }
+    if (wait && timeOutSec_ > 0) {
+        timeoutExpired_ = false;
+        timeout_[0] = timeOutSec_;
+        timeout_[1] = 0;
+        const unsigned tail = *sqTail_;
+        auto sqe = static_cast<struct io_uring_sqe *>(sqes_) + (tail & *sqMask_);
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->addr = reinterpret_cast<uint64_t>(timeout_);
+        sqe->len = 1;
+        // completes after one other completion or at expiry
+        sqe->off = 1;
+        sqe->user_data = timeoutTag;
+        sqArray_[tail & *sqMask_] = tail & *sqMask_;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit_;
+    }
+    if (toSubmit_ > 0 || wait) {
+        int ret(0);
+        TraceSpan span("io_uring_enter", "net", "submit", toSubmit_);
+        do {
+            ret = io_uring_enter(ringFd_, toSubmit_, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+        } while (ret < 0 && errno == EINTR);
+        span.end();
+        if (ret < 0) {
+            return false;
+        }
+        toSubmit_ -= std::min<unsigned>(toSubmit_, static_cast<unsigned>(ret));
+    }
+    batch_ = 0;
+    reap();
+    return true;
+}
+
+int IoUringTransport::sendv(size_t idx, const DataPart *parts, size_t count)
+{
+    auto &lane = lanes_[idx];
+    size_t total(0);
+    for (size_t i = 0; i < count; ++i) {
+        const auto &part = parts[i];
+        size_t queued(0);
+        while (queued < part.length_) {
+            if (lane.err_ != 0) {
+                return lane_error(lane);
+            }
+            if (lane.size_ == capacity_) {
+                if (!submit(true)) {
+                    return -1;
+                }
+                if (timeoutExpired_) {
+                    errno = ETIMEDOUT;
+                    return -1;
+                }
+                continue;
+            }
+            const size_t tail = (lane.head_ + lane.size_) % capacity_;
+            const size_t chunk = std::min(part.length_ - queued,
+                                          std::min(capacity_ - lane.size_, capacity_ - tail));
+            if (part.data_) {
+                memcpy(lane.buf_ + tail, part.data_ + queued, chunk);
+            } else {
+                memset(lane.buf_ + tail, 0, chunk);
+            }
+            lane.size_ += chunk;
+            queued += chunk;
+        }
+        total += part.length_;
+    }
+    // one submission for every round of blocks over all sockets
+    if (++batch_ >= lanes_.size() && !submit(false)) {
+        return -1;
+    }
+    return static_cast<int>(total);
+}
+
+int IoUringTransport::receive(size_t idx, char *data, int length)
+{
+    auto &lane = lanes_[idx];
+    size_t received(0);
+    while (received < static_cast<size_t>(length)) {
+        if (0 == lane.size_) {
+            reap();
+            if (0 == lane.size_ && lane.err_ != 0) {
+                // only the empty closed lane fails, the other lanes keep their blocks
+                return lane_error(lane);
+            }
+            if (0 == lane.size_) {
+                if (!submit(true)) {
+                    return -1;
+                }
+                if (timeoutExpired_) {
+                    errno = ETIMEDOUT;
+                    return -1;
+                }
+            }
+            continue;
+        }
+        const size_t chunk = std::min(static_cast<size_t>(length) - received,
+                                      std::min(lane.size_, capacity_ - lane.head_));
+        memcpy(data + received, lane.buf_ + lane.head_, chunk);
+        lane.head_ = (lane.head_ + chunk) % capacity_;
+        lane.size_ -= chunk;
+        received += chunk;
+    }
+    // re-arm reads of the drained sockets once per round of blocks
+    if (++batch_ >= lanes_.size() && !submit(false)) {
+        return -1;
+    }
+    return length;
+}
+
+bool IoUringTransport::flush()
+{
+    for (;;) {
+        bool pending(false);
+        for (const auto &lane : lanes_) {
+            if (lane.size_ > 0 && lane.err_ != 0) {
+                // the queued data of failed lane is lost
+                lane_error(lane);
+                return false;
+            }
+            pending = pending || lane.size_ > 0;
+        }
+        if (!pending) {
+            return true;
+        }
+        if (!submit(true)) {
+            return false;
+        }
+        if (timeoutExpired_) {
+            errno = ETIMEDOUT;
+            return false;
+        }
+    }
+}
+
+#else // not TCPCLIENT_HAVE_IO_URING
+
+IoUringTransport::~IoUringTransport() {}
+
+bool IoUringTransport::init()
+{
+    return false;
+}
+
+bool IoUringTransport::prepare(const size_t)
+{
+    return false;
+}
+
+void IoUringTransport::reap() {}
+
+int IoUringTransport::lane_error(const Lane &) const
+{
+    return -1;
+}
+
+bool IoUringTransport::submit(const bool)
+{
+    return false;
+}
+
+int IoUringTransport::sendv(size_t, const DataPart *, size_t)
+{
+    return -1;
+}
+
+int IoUringTransport::receive(size_t, char *, int)
+{
+    return -1;
+}
+
+bool IoUringTransport::flush()
+{
+    return false;
+}
+
+#endif // TCPCLIENT_HAVE_IO_URING
@@ -0,0 +1,104 @@
+/** @file tcpiouring.h
+ * @brief io_uring engine for TCPClient
+ */
+#ifndef TCPIOURING_H
+#define TCPIOURING_H
+
+#include "tcptransport.h"
+
+/**
+ * @class IoUringTransport
+ * @brief Every socket has a ring of registered (fixed) buffers of queueDepth blocks.
+ * Writes (reads) of all sockets are submitted to io_uring by one system call.
+ * @par One operation per socket is in flight, it covers all blocks which are queued
+ * (free) in the ring of the socket, so the order of data on every socket is kept.
+ * If the buffers can not be registered (RLIMIT_MEMLOCK) not fixed operations are used.
+ */
+class IoUringTransport : public BlockTransport
+{
+public:
+    /**
+     * @brief Constructor
+     * @param sockets - sockets of one direction
+     * @param isReceive - true for receive sockets, false for send sockets
+     * @param blockSize - size of TCP block in bytes
+     * @param queueDepth - size of ring of every socket in blocks
+     * @param timeOutSec - time out of waiting of socket, seconds (0 - infinite)
+     */
+    IoUringTransport(const std::vector<DS_SOCKET> &sockets, const bool isReceive, const uint32_t blockSize,
+                     const uint32_t queueDepth, const int timeOutSec);
+    virtual ~IoUringTransport();
+    /**
+     * @brief Create io_uring instance and register buffers
+     * @return false if io_uring is not supported by system
+     */
+    bool init();
+    virtual int sendv(size_t lane, const DataPart *parts, size_t count);
+    virtual int receive(size_t lane, char *data, int length);
+    virtual bool flush();
+    virtual size_t queued(size_t lane) const
+    {
+        return lanes_[lane].size_;
+    }
+    virtual const char *name() const
+    {
+        return isFixed_ ? "io_uring (registered buffers)" : "io_uring";
+    }
+
+private:
+    /// Ring of buffers of one socket
+    struct Lane {
+        DS_SOCKET sock_;
+        /// Begin of ring in the common buffer
+        char *buf_;
+        /// Offset of first queued byte
+        size_t head_;
+        /// Count of queued bytes (data which is not written yet or is not taken by receive)
+        size_t size_;
+        /// The operation of this lane is submitted and not completed
+        bool inFlight_;
+        /// errno of failure of socket (ECONNRESET if it is closed by server), 0 - socket is open
+        int err_;
+        Lane() : sock_(0), buf_(nullptr), head_(0), size_(0), inFlight_(false), err_(0) {}
+    };
+    /// Prepare operations for all idle lanes and submit them, wait for one completion if \"wait\"
+    bool submit(const bool wait);
+    /// Process all available completions, the failed operation closes only its own lane
+    void reap();
+    bool prepare(const size_t idx);
+    /// Set errno of the failed lane, always -1
+    int lane_error(const Lane &lane) const;
+
+    std::vector<Lane> lanes_;
+    bool isReceive_;
+    size_t capacity_;
+    int timeOutSec_;
+    bool isFixed_;
+    /// Count of blocks accepted since last submission
+    size_t batch_;
+    /// Count of prepared and not submitted operations
+    unsigned toSubmit_;
+    /// The timeout of last wait is expired, it is cleared by every new wait
+    bool timeoutExpired_;
+    /// struct __kernel_timespec of the timeout operation
+    int64_t timeout_[2];
+    char *memory_;
+
+    int ringFd_;
+    void *sqPtr_;
+    void *cqPtr_;
+    size_t sqSize_;
+    size_t cqSize_;
+    void *sqes_;
+    size_t sqesSize_;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned *sqMask_;
+    unsigned *sqArray_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned *cqMask_;
+    void *cqes_;
+};
+
+#endif // TCPIOURING_H
@@ -0,0 +1,381 @@
+#include "tcpmetrics.h"
+#include "tcpclientapp.h"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+namespace {
+/// Period of check of stop flag and of HTTP requests
+const int pollStepMs = 100;
+/// Percentiles of latencies in the metrics and in the report
+const double metricPercents[] = { 50, 90, 99, 99.9 };
+
+void closeSocket(const DS_SOCKET sock)
+{
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(static_cast<int>(sock));
+#endif
+}
+
+/// The client of HTTP endpoint does not block the exporter longer than this time
+void setReceiveTimeout(const DS_SOCKET sock, const int ms)
+{
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(ms);
+#else
+    struct timeval timeout;
+    timeout.tv_sec = ms / 1000;
+    timeout.tv_usec = (ms % 1000) * 1000;
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+}
+
+/// Escape string for JSON and for value of Prometheus label
+std::string escape(const std::string &str)
+{
+    std::string res;
+    for (const auto c : str) {
+        if ('"' == c || '\\' == c) {
+            res += '\\';
+            res += c;
+        } else if ('\n' == c) {
+            res += "\\n";
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            res += c;
+        }
+    }
+    return res;
+}
+
+/// Configuration of connection as pairs of name and value
+std::vector<std::pair<std::string, std::string>> configOf(TCPClient &client)
+{
+    const auto &info = client.get_connection_info();
+    return {
+        { "host", info.remoteAddress_ },
+        { "port", std::to_string(info.port_) },
+        { "io_mode", utils::name_of(utils::typesOfIoMode, info.ioMode_) },
+        { "queue_depth", std::to_string(info.ioQueueDepth_) },
+        { "block_size", std::to_string(info.tcpBufSize_) },
+        { "n_sockets", std::to_string(info.nSockets_) },
+        { "duplex", info.isDuplexSockets_ ? "1" : "0" },
+        { "scheduler", utils::name_of(utils::typesOfScheduler, info.scheduler_) },
+        { "window_bytes", std::to_string(info.windowBytes_ > 0 ? info.windowBytes_
+                                         : uint64_t(info.windowBlocks_) * info.tcpBufSize_) },
+        { "instrument", utils::name_of(utils::typesOfInstrument, info.instrumentMode_) },
+        { "compression", utils::name_of(utils::typesOfCompression, client.get_codec()) },
+    };
+}
+
+/// Counters and latencies of one direction of socket as JSON object
+std::string directionJson(const IoCounters &counters, const LatencyHistogram &latency)
+{
+    std::ostringstream ss;
+    ss << "{\"bytes\": " << counters.bytes_.load(std::memory_order_relaxed)
+       << ", \"operations\": " << counters.ops_.load(std::memory_order_relaxed)
+       << ", \"time_ns\": " << counters.timeNs_.load(std::memory_order_relaxed)
+       << ", \"last_error\": " << counters.error_.load(std::memory_order_relaxed)
+       << ", \"latency_ns\": {\"count\": " << latency.count();
+    for (const auto percent : metricPercents) {
+        ss << ", \"p" << percent << "\": " << latency.percentile(percent);
+    }
+    ss << ", \"max\": " << latency.max() << "}}";
+    return ss.str();
+}
+
+std::string timeToString(const std::chrono::system_clock::time_point &time)
+{
+    const auto t = std::chrono::system_clock::to_time_t(time);
+    char buf[32];
+    if (0 == std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t))) {
+        return "";
+    }
+    return buf;
+}
+}  // namespace
+
+MetricsExporter::MetricsExporter(TCPClient &client, const std::string &fileName, const int port, const int intervalMs)
+    : client_(client)
+    , fileName_(fileName)
+    , port_(port)
+    , intervalMs_(std::max(pollStepMs, intervalMs))
+    , listenSocket_(0)
+    , stop_(false)
+    , lastTime_(std::chrono::steady_clock::now())
+    , lastSent_(0)
+    , lastReceived_(0)
+    , sendRate_(0)
+    , rcvRate_(0)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start()
+{
+    if (port_ > 0) {
+        listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (static_cast<int>(listenSocket_) < 0) {
+            std::cerr << errno << ": Error open socket of metrics." << std::endl;
+            return false;
+        }
+        int reuse(1);
+        setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port_));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenSocket_, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenSocket_, 4) != 0) {
+            std::cerr << errno << ": Error listen port " << port_ << " of metrics." << std::endl;
+            closeSocket(listenSocket_);
+            listenSocket_ = 0;
+            return false;
+        }
+        std::cout << "Metrics:                           http://127.0.0.1:" << port_ << "/metrics" << std::endl;
+    }
+    if (!fileName_.empty()) {
+        std::cout << "Metrics:                           " << fileName_ << std::endl;
+    }
+    lastTime_ = std::chrono::steady_clock::now();
+    lastSent_ = client_.get_total_bytes_sent();
+    lastReceived_ = client_.get_total_bytes_received();
+    stop_ = false;
+    thread_ = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    if (!thread_.joinable()) {
+        return;
+    }
+    stop_ = true;
+    thread_.join();
+    if (listenSocket_ != 0) {
+        closeSocket(listenSocket_);
+        listenSocket_ = 0;
+    }
+    if (!fileName_.empty()) {
+        write_file(text());
+    }
+}
+
+void MetricsExporter::run()
+{
+    auto nextWrite = std::chrono::steady_clock::now();
+    while (!stop_) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= nextWrite) {
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastTime_).count();
+            const auto sent = client_.get_total_bytes_sent();
+            const auto received = client_.get_total_bytes_received();
+            if (ns > 0) {
+                sendRate_ = double(sent - lastSent_) * 1e9 / double(ns);
+                rcvRate_ = double(received - lastReceived_) * 1e9 / double(ns);
+            }
+            lastTime_ = now;
+            lastSent_ = sent;
+            lastReceived_ = received;
+            if (!fileName_.empty()) {
+                write_file(text());
+            }
+            nextWrite = now + std::chrono::milliseconds(intervalMs_);
+        }
+        if (0 == listenSocket_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollStepMs));
+            continue;
+        }
+        struct pollfd fd;
+        fd.fd = listenSocket_;
+        fd.events = POLLIN;
+        fd.revents = 0;
+#ifdef _WIN32
+        int ret = WSAPoll(&fd, 1, pollStepMs);
+#else
+        int ret = ::poll(&fd, 1, pollStepMs);
+#endif
+        if (ret > 0 && (fd.revents & POLLIN)) {
+            auto sock = accept(listenSocket_, nullptr, nullptr);
+            if (static_cast<int>(sock) >= 0) {
+                serve_client(sock);
+                closeSocket(sock);
+            }
+        }
+    }
+}
+
+void MetricsExporter::serve_client(const DS_SOCKET sock)
+{
+    // the request is not parsed, every path gets the metrics
+    char request[1024];
+    setReceiveTimeout(sock, 1000);
+    recv(sock, request, sizeof(request), 0);
+    const auto body = text();
+    const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                                 std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    size_t sent(0);
+    while (sent < response.size()) {
+        auto bytes = ::send(sock, response.data() + sent, static_cast<int>(response.size() - sent), 0);
+        if (bytes <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(bytes);
+    }
+}
+
+bool MetricsExporter::write_file(const std::string &text) const
+{
+    const std::string tmpName(fileName_ + ".tmp");
+    {
+        std::ofstream ofs(tmpName, std::ofstream::out | std::ofstream::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "File \"" << tmpName << "\" not created." << std::endl;
+            return false;
+        }
+        ofs << text;
+        if (!ofs.good()) {
+            return false;
+        }
+    }
+    // the reader never sees a part of file
+#ifdef _WIN32
+    std::remove(fileName_.c_str());
+#endif
+    return 0 == std::rename(tmpName.c_str(), fileName_.c_str());
+}
+
+std::string MetricsExporter::text()
+{
+    const auto blockSize = std::max<uint64_t>(1, client_.get_connection_info().tcpBufSize_);
+    const auto sent = client_.get_total_bytes_sent();
+    const auto received = client_.get_total_bytes_received();
+    std::ostringstream ss;
+    ss << "# HELP tcpclient_info Configuration of connection\n# TYPE tcpclient_info gauge\ntcpclient_info{";
+    bool first(true);
+    for (const auto &it : configOf(client_)) {
+        ss << (first ? "" : ",") << it.first << "=\"" << escape(it.second) << "\"";
+        first = false;
+    }
+    ss << "} 1\n";
+    ss << "# TYPE tcpclient_sent_bytes_total counter\ntcpclient_sent_bytes_total " << sent << "\n"
+       << "# TYPE tcpclient_received_bytes_total counter\ntcpclient_received_bytes_total " << received << "\n"
+       << "# TYPE tcpclient_sent_blocks_total counter\ntcpclient_sent_blocks_total " << sent / blockSize << "\n"
+       << "# TYPE tcpclient_received_blocks_total counter\ntcpclient_received_blocks_total " << received / blockSize << "\n"
+       << "# HELP tcpclient_transfer_sent_bytes Bytes of current transfer, reset after every transfer\n"
+       << "# TYPE tcpclient_transfer_sent_bytes gauge\ntcpclient_transfer_sent_bytes " << client_.get_bytes_sent() << "\n"
+       << "# HELP tcpclient_transfer_received_bytes Bytes of current transfer, reset after every transfer\n"
+       << "# TYPE tcpclient_transfer_received_bytes gauge\ntcpclient_transfer_received_bytes " << client_.get_bytes_received()
+       << "\n"
+       << "# HELP tcpclient_send_bytes_per_second Throughput of sending in last interval\n"
+       << "# TYPE tcpclient_send_bytes_per_second gauge\ntcpclient_send_bytes_per_second " << sendRate_ << "\n"
+       << "# HELP tcpclient_receive_bytes_per_second Throughput of receiving in last interval\n"
+       << "# TYPE tcpclient_receive_bytes_per_second gauge\ntcpclient_receive_bytes_per_second " << rcvRate_ << "\n"
+       << "# HELP tcpclient_error Error of client, 0 - no error\n# TYPE tcpclient_error gauge\ntcpclient_error "
+       << client_.get_error() << "\n";
+
+    std::ostringstream bytes, ops, errors, latency, samples;
+    bytes << "# TYPE tcpclient_socket_bytes_total counter\n";
+    ops << "# TYPE tcpclient_socket_operations_total counter\n";
+    errors << "# TYPE tcpclient_socket_last_error gauge\n";
+    // the histograms are reset after every transfer, so their quantiles and count are not a summary
+    latency << "# HELP tcpclient_socket_latency_seconds Quantiles of latencies of current transfer\n"
+            << "# TYPE tcpclient_socket_latency_seconds gauge\n";
+    samples << "# HELP tcpclient_socket_latency_samples Timed operations of current transfer\n"
+            << "# TYPE tcpclient_socket_latency_samples gauge\n";
+    for (const auto &state : client_.get_socket_states()) {
+        if (!state) {
+            continue;
+        }
+        const IoCounters *counters[] = { &state->sent_, &state->received_ };
+        const LatencyHistogram *histograms[] = { &state->sendLatency_, &state->rcvLatency_ };
+        const char *directions[] = { "send", "receive" };
+        for (size_t i = 0; i < 2; ++i) {
+            const std::string labels = "socket=\"" + std::to_string(state->id_) + "\",direction=\"" + directions[i] + "\"";
+            bytes << "tcpclient_socket_bytes_total{" << labels << "} " << counters[i]->totalBytes_.load(std::memory_order_relaxed)
+                  << "\n";
+            ops << "tcpclient_socket_operations_total{" << labels << "} " << counters[i]->totalOps_.load(std::memory_order_relaxed)
+                << "\n";
+            errors << "tcpclient_socket_last_error{" << labels << "} " << counters[i]->error_.load(std::memory_order_relaxed) << "\n";
+            if (histograms[i]->count() > 0) {
+                for (const auto percent : metricPercents) {
+                    latency << "tcpclient_socket_latency_seconds{" << labels << ",quantile=\"" << percent / 100 << "\"} "
+                            << double(histograms[i]->percentile(percent)) / 1e9 << "\n";
+                }
+                samples << "tcpclient_socket_latency_samples{" << labels << "} " << histograms[i]->count() << "\n";
+            }
+        }
+    }
+    ss << bytes.str() << ops.str() << errors.str() << latency.str() << samples.str();
+    return ss.str();
+}
+
+RunReport::RunReport()
+    : start_(std::chrono::system_clock::now())
+{
+}
+
+void RunReport::add_transfer(TCPClient &client, const std::string &name, const double seconds, const bool ok)
+{
+    const auto blockSize = std::max<uint64_t>(1, client.get_connection_info().tcpBufSize_);
+    const auto sent = client.get_bytes_sent();
+    const auto received = client.get_bytes_received();
+    std::ostringstream ss;
+    ss << "{\"name\": \"" << escape(name) << "\", \"ok\": " << (ok ? "true" : "false")
+       << ", \"seconds\": " << seconds
+       << ", \"bytes_sent\": " << sent << ", \"bytes_received\": " << received
+       << ", \"blocks_sent\": " << sent / blockSize << ", \"blocks_received\": " << received / blockSize
+       << ", \"send_gbps\": " << (seconds > 0 ? double(sent) * 8 / seconds / 1e9 : 0)
+       << ", \"receive_gbps\": " << (seconds > 0 ? double(received) * 8 / seconds / 1e9 : 0)
+       << ", \"error\": " << client.get_error()
+       << ", \"sockets\": [";
+    bool first(true);
+    for (const auto &state : client.get_socket_states()) {
+        if (!state) {
+            continue;
+        }
+        ss << (first ? "" : ", ") << "{\"id\": " << state->id_
+           << ", \"send\": " << directionJson(state->sent_, state->sendLatency_)
+           << ", \"receive\": " << directionJson(state->received_, state->rcvLatency_)
+           << ", \"gap_latency_ns\": {\"count\": " << state->gapLatency_.count()
+           << ", \"p99\": " << state->gapLatency_.percentile(99) << ", \"max\": " << state->gapLatency_.max() << "}}";
+        first = false;
+    }
+    ss << "]}";
+    transfers_.push_back(ss.str());
+}
+
+bool RunReport::write(const std::string &fileName, TCPClient &client) const
+{
+    const auto end = std::chrono::system_clock::now();
+    std::ofstream ofs(fileName, std::ofstream::out | std::ofstream::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "File \"" << fileName << "\" not created." << std::endl;
+        return false;
+    }
+    ofs << "{\n  \"start\": \"" << timeToString(start_) << "\",\n  \"end\": \"" << timeToString(end) << "\",\n"
+        << "  \"seconds\": " << std::chrono::duration<double>(end - start_).count() << ",\n  \"config\": {";
+    bool first(true);
+    for (const auto &it : configOf(client)) {
+        ofs << (first ? "" : ", ") << "\"" << it.first << "\": \"" << escape(it.second) << "\"";
+        first = false;
+    }
+    ofs << "},\n  \"error\": " << client.get_error() << ",\n  \"transfers\": [";
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+        ofs << (i > 0 ? ",\n    " : "\n    ") << transfers_[i];
+    }
+    ofs << "\n  ]\n}\n";
+    return ofs.good();
+}
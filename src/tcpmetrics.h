@@ -0,0 +1,80 @@
+/** @file tcpmetrics.h
+ * @brief Live metrics of TCPClient in Prometheus text format and JSON report of run
+ */
+#ifndef TCPMETRICS_H
+#define TCPMETRICS_H
+
+#include "tcpclient.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class MetricsExporter
+ * @brief Publishes the counters of TCPClient in Prometheus text format: the file is rewritten
+ * every interval (through temporary file and rename, as the textfile collector of node_exporter needs),
+ * the HTTP endpoint http://127.0.0.1:<port>/metrics is served by the same thread.
+ * @par The *_total counters are the totals since the start (IoCounters::totalBytes_), the statistics which
+ * TCPClient::finish_transfer() resets after every transfer are gauges of the current transfer.
+ * The exporter must be stopped before the client is reconnected.
+ */
+class MetricsExporter
+{
+public:
+    /**
+     * @param fileName - file of metrics, empty - no file
+     * @param port - port of HTTP endpoint, 0 - no endpoint
+     * @param intervalMs - period of writing of file and of measuring of throughput
+     */
+    MetricsExporter(TCPClient &client, const std::string &fileName, const int port, const int intervalMs);
+    ~MetricsExporter();
+    /// Start the thread of exporter, false if the port is not listened
+    bool start();
+    /// Stop the thread, the file is written the last time
+    void stop();
+    /// Metrics of client in Prometheus text format
+    std::string text();
+
+private:
+    void run();
+    bool write_file(const std::string &text) const;
+    void serve_client(const DS_SOCKET sock);
+
+    TCPClient &client_;
+    std::string fileName_;
+    int port_;
+    int intervalMs_;
+    DS_SOCKET listenSocket_;
+    std::thread thread_;
+    std::atomic<bool> stop_;
+    /// Counters at last measuring of throughput
+    std::chrono::steady_clock::time_point lastTime_;
+    uint64_t lastSent_;
+    uint64_t lastReceived_;
+    double sendRate_;
+    double rcvRate_;
+};
+
+/**
+ * @class RunReport
+ * @brief Report of run in JSON: configuration of connection and the statistics of every transfer
+ * (bytes, blocks, throughput, errors and every socket with percentiles of latencies).
+ * The statistics are taken by add_transfer() before TCPClient::finish_transfer() resets them.
+ */
+class RunReport
+{
+public:
+    RunReport();
+    /// Take the statistics of finished transfer of client
+    void add_transfer(TCPClient &client, const std::string &name, const double seconds, const bool ok);
+    /// Write the report, the configuration is taken from client
+    bool write(const std::string &fileName, TCPClient &client) const;
+
+private:
+    std::chrono::system_clock::time_point start_;
+    /// Transfers as JSON objects
+    std::vector<std::string> transfers_;
+};
+
+#endif // TCPMETRICS_H
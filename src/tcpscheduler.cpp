@@ -0,0 +1,131 @@
+#include "tcpscheduler.h"
+#include "tcptransport.h"
+
+#include <limits>
+#include <algorithm>
+
+#ifdef __linux__
+#include <linux/sockios.h>
+#endif
+
+namespace {
+/// Weight of new sample in the moving average of throughput
+const double rateAlpha = 0.125;
+/// Min weight of socket as part of weight of the fastest socket
+const double minShare = 0.05;
+/// Interval of measurement of throughput of sockets
+const std::chrono::milliseconds sampleInterval(5);
+
+/// Count of bytes in the send queue of kernel, 0 if not supported
+size_t unsentBytes(const DS_SOCKET sock)
+{
+#ifdef SIOCOUTQ
+    int bytes(0);
+    if (ioctl(static_cast<int>(sock), SIOCOUTQ, &bytes) == 0 && bytes > 0) {
+        return static_cast<size_t>(bytes);
+    }
+#else
+    (void)sock;
+#endif
+    return 0;
+}
+}  // namespace
+
+SendScheduler *SendScheduler::create(const SchedulerType type, const std::vector<DS_SOCKET> &sockets,
+                                     const BlockTransport *transport)
+{
+    if (SchedulerType::LeastLoaded == type) {
+        return new LeastLoadedScheduler(sockets, transport);
+    }
+    if (SchedulerType::Weighted == type) {
+        return new WeightedScheduler(sockets, transport);
+    }
+    return nullptr;
+}
+
+LeastLoadedScheduler::LeastLoadedScheduler(const std::vector<DS_SOCKET> &sockets, const BlockTransport *transport)
+    : sockets_(sockets)
+    , transport_(transport)
+    , last_(sockets.size() - 1)
+{
+}
+
+size_t LeastLoadedScheduler::next()
+{
+    size_t best(0);
+    size_t bestLoad(std::numeric_limits<size_t>::max());
+    for (size_t i = 1; i <= sockets_.size(); ++i) {
+        const size_t idx = (last_ + i) % sockets_.size();
+        size_t load = unsentBytes(sockets_[idx]);
+        if (transport_) {
+            load += transport_->queued(idx);
+        }
+        if (load < bestLoad) {
+            best = idx;
+            bestLoad = load;
+            if (0 == load) {
+                break;
+            }
+        }
+    }
+    last_ = best;
+    return best;
+}
+
+WeightedScheduler::WeightedScheduler(const std::vector<DS_SOCKET> &sockets, const BlockTransport *transport)
+    : sockets_(sockets)
+    , transport_(transport)
+    , rate_(sockets.size(), 1.0)
+    , current_(sockets.size(), 0.0)
+    , accepted_(sockets.size(), 0)
+    , drained_(sockets.size(), 0)
+    , lastSample_(std::chrono::steady_clock::now())
+{
+}
+
+size_t WeightedScheduler::next()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (now - lastSample_ >= sampleInterval) {
+        sample(now);
+    }
+    // the slow socket keeps a minimal weight, so its throughput is measured again
+    const double minRate = *std::max_element(rate_.begin(), rate_.end()) * minShare;
+    double total(0);
+    size_t best(0);
+    for (size_t i = 0; i < rate_.size(); ++i) {
+        const double weight = std::max(rate_[i], minRate);
+        current_[i] += weight;
+        total += weight;
+        if (current_[i] > current_[best]) {
+            best = i;
+        }
+    }
+    current_[best] -= total;
+    return best;
+}
+
+void WeightedScheduler::sent(size_t idx, size_t bytes)
+{
+    accepted_[idx] += bytes;
+}
+
+void WeightedScheduler::sample(const std::chrono::steady_clock::time_point now)
+{
+    const double ns = std::chrono::duration<double, std::nano>(now - lastSample_).count();
+    lastSample_ = now;
+    for (size_t i = 0; i < sockets_.size(); ++i) {
+        uint64_t pending = unsentBytes(sockets_[i]);
+        if (transport_) {
+            pending += transport_->queued(i);
+        }
+        const uint64_t drained = accepted_[i] > pending ? accepted_[i] - pending : 0;
+        const uint64_t bytes = drained > drained_[i] ? drained - drained_[i] : 0;
+        drained_[i] = std::max(drained_[i], drained);
+        const double rate = double(bytes) / ns;
+        // the socket which has sent all its data could send more, so its weight is only raised
+        if (pending > 0 || rate > rate_[i]) {
+            rate_[i] += rateAlpha * (rate - rate_[i]);
+        }
+    }
+}
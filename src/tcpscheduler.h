@@ -0,0 +1,102 @@
+/** @file tcpscheduler.h
+ * @brief Choice of send socket for every block of TCPClient
+ */
+#ifndef TCPSCHEDULER_H
+#define TCPSCHEDULER_H
+
+#include "tcpclient.h"
+
+#include <chrono>
+
+class BlockTransport;
+
+/**
+ * @class SendScheduler
+ * @brief Picks the send socket of the next block.
+ * @par The sockets which are not picked by turns need the same order on the receive side,
+ * TCPClient keeps the log of picked sockets and reads the blocks back in its order.
+ */
+class SendScheduler
+{
+public:
+    virtual ~SendScheduler() {}
+    /// Index of send socket for the next block
+    virtual size_t next() = 0;
+    /**
+     * @brief The block is accepted by the socket (or by the queue of engine)
+     * @param idx - index of send socket
+     * @param bytes - size of block
+     */
+    virtual void sent(size_t idx, size_t bytes)
+    {
+        (void)idx;
+        (void)bytes;
+    }
+    virtual const char *name() const = 0;
+    /**
+     * @brief Create scheduler of type
+     * @param type - type of scheduler, nullptr for SchedulerType::RoundRobin (TCPClient uses sockets by turns itself)
+     * @param sockets - send sockets
+     * @param transport - engine of sending, its queues are counted as load of sockets (may be nullptr)
+     */
+    static SendScheduler *create(const SchedulerType type, const std::vector<DS_SOCKET> &sockets,
+                                 const BlockTransport *transport);
+};
+
+/**
+ * @class LeastLoadedScheduler
+ * @brief The socket with the least unsent bytes: the queue of engine plus the send queue
+ * of kernel (SIOCOUTQ). The equal sockets are used by turns.
+ */
+class LeastLoadedScheduler : public SendScheduler
+{
+public:
+    LeastLoadedScheduler(const std::vector<DS_SOCKET> &sockets, const BlockTransport *transport);
+    virtual size_t next();
+    virtual const char *name() const
+    {
+        return "least-loaded";
+    }
+
+private:
+    std::vector<DS_SOCKET> sockets_;
+    const BlockTransport *transport_;
+    /// The search starts after the last picked socket
+    size_t last_;
+};
+
+/**
+ * @class WeightedScheduler
+ * @brief Smooth weighted round-robin, the weight of socket is its recent throughput
+ * (exponential moving average of bytes per nanosecond).
+ * @par The throughput is measured by the scheduler itself, so it does not depend on --instrument
+ * and on the I/O engine: the bytes which have left the socket in every interval are the bytes given
+ * to it minus the bytes which are still in the queue of engine and in the send queue of kernel (SIOCOUTQ).
+ */
+class WeightedScheduler : public SendScheduler
+{
+public:
+    WeightedScheduler(const std::vector<DS_SOCKET> &sockets, const BlockTransport *transport);
+    virtual size_t next();
+    virtual void sent(size_t idx, size_t bytes);
+    virtual const char *name() const
+    {
+        return "weighted";
+    }
+
+private:
+    /// Update the rates of sockets by the bytes which have left them since the last sample
+    void sample(const std::chrono::steady_clock::time_point now);
+
+    std::vector<DS_SOCKET> sockets_;
+    const BlockTransport *transport_;
+    std::vector<double> rate_;
+    std::vector<double> current_;
+    /// Bytes given to the socket since start
+    std::vector<uint64_t> accepted_;
+    /// Bytes which have left the socket till the last sample
+    std::vector<uint64_t> drained_;
+    std::chrono::steady_clock::time_point lastSample_;
+};
+
+#endif // TCPSCHEDULER_H
@@ -0,0 +1,238 @@
+#include "tcpthreaded.h"
+#include "tcptrace.h"
+
+#include <iostream>
+#include <algorithm>
+#include <system_error>
+
+#ifdef MSG_NOSIGNAL
+#define TCP_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define TCP_SEND_FLAGS 0
+#endif
+
+namespace {
+/// The socket call is interrupted or its time out (SO_SNDTIMEO/SO_RCVTIMEO) is expired
+bool isRetry(const int err)
+{
+    return err == EINTR || err == EAGAIN || err == EWOULDBLOCK || err == D_EWOULDBLOCK;
+}
+}  // namespace
+
+ThreadedTransport::ThreadedTransport(const std::vector<DS_SOCKET> &sockets, const bool isReceive,
+                                     const uint32_t blockSize, const uint32_t queueDepth, const int timeOutSec)
+    : isReceive_(isReceive)
+    , capacity_(static_cast<size_t>(blockSize) * std::max<uint32_t>(1, queueDepth))
+    , timeOutSec_(timeOutSec)
+{
+    for (auto sock : sockets) {
+        lanes_.emplace_back(new Lane());
+        lanes_.back()->sock_ = sock;
+        lanes_.back()->buf_.resize(capacity_);
+    }
+}
+
+ThreadedTransport::~ThreadedTransport()
+{
+    for (auto &lane : lanes_) {
+        {
+            std::lock_guard<std::mutex> lock(lane->mutex_);
+            lane->stop_ = true;
+        }
+        lane->cv_.notify_all();
+    }
+    for (auto &lane : lanes_) {
+        if (lane->worker_.joinable()) {
+            lane->worker_.join();
+        }
+    }
+}
+
+bool ThreadedTransport::init()
+{
+    try {
+        for (auto &lane : lanes_) {
+            Lane &l = *lane;
+            if (isReceive_) {
+                lane->worker_ = std::thread([this, &l]() {
+                    Tracer::set_thread_name("receive fd " + std::to_string(l.sock_));
+                    receive_worker(l);
+                });
+            } else {
+                lane->worker_ = std::thread([this, &l]() {
+                    Tracer::set_thread_name("send fd " + std::to_string(l.sock_));
+                    send_worker(l);
+                });
+            }
+        }
+    } catch (const std::system_error &e) {
+        std::cerr << e.code().value() << ": Error start of socket thread." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename Predicate>
+bool ThreadedTransport::wait(Lane &lane, std::unique_lock<std::mutex> &lock, Predicate pred)
+{
+    if (timeOutSec_ > 0) {
+        return lane.cv_.wait_for(lock, std::chrono::seconds(timeOutSec_), pred);
+    }
+    lane.cv_.wait(lock, pred);
+    return true;
+}
+
+void ThreadedTransport::send_worker(Lane &lane)
+{
+    std::unique_lock<std::mutex> lock(lane.mutex_);
+    for (;;) {
+        lane.cv_.wait(lock, [&lane]() {
+            return lane.size_ > 0 || lane.stop_;
+        });
+        if (lane.stop_) {
+            break;
+        }
+        // the queued region is not changed by TCPClient, so it is written without the lock
+        const size_t head = lane.head_;
+        const size_t chunk = std::min(lane.size_, capacity_ - head);
+        lock.unlock();
+        TraceSpan span("send", "net", "fd", static_cast<int64_t>(lane.sock_));
+        auto bytes = ::send(lane.sock_, &lane.buf_[head], static_cast<int>(chunk), TCP_SEND_FLAGS);
+        span.end();
+        const int err = bytes < 0 ? GetLastError() : 0;
+        lock.lock();
+        if (bytes < 0) {
+            if (isRetry(err)) {
+                continue;
+            }
+            lane.error_ = err;
+            lane.cv_.notify_all();
+            break;
+        }
+        lane.head_ = (head + static_cast<size_t>(bytes)) % capacity_;
+        lane.size_ -= static_cast<size_t>(bytes);
+        lane.cv_.notify_all();
+    }
+}
+
+void ThreadedTransport::receive_worker(Lane &lane)
+{
+    std::unique_lock<std::mutex> lock(lane.mutex_);
+    for (;;) {
+        lane.cv_.wait(lock, [this, &lane]() {
+            return lane.size_ < capacity_ || lane.stop_;
+        });
+        if (lane.stop_) {
+            break;
+        }
+        // the free region is not used by TCPClient, so it is read without the lock
+        const size_t tail = (lane.head_ + lane.size_) % capacity_;
+        const size_t chunk = std::min(capacity_ - lane.size_, capacity_ - tail);
+        lock.unlock();
+        TraceSpan span("recv", "net", "fd", static_cast<int64_t>(lane.sock_));
+        auto bytes = ::recv(lane.sock_, &lane.buf_[tail], static_cast<int>(chunk), 0);
+        span.end();
+        const int err = bytes < 0 ? GetLastError() : 0;
+        lock.lock();
+        if (bytes < 0 && isRetry(err)) {
+            continue;
+        }
+        if (bytes <= 0) {
+            // 0 - connection is closed by server
+            lane.error_ = bytes < 0 ? err : -1;
+            lane.cv_.notify_all();
+            break;
+        }
+        lane.size_ += static_cast<size_t>(bytes);
+        lane.cv_.notify_all();
+    }
+}
+
+int ThreadedTransport::sendv(size_t idx, const DataPart *parts, size_t count)
+{
+    auto &lane = *lanes_[idx];
+    std::unique_lock<std::mutex> lock(lane.mutex_);
+    size_t total(0);
+    for (size_t i = 0; i < count; ++i) {
+        const auto &part = parts[i];
+        size_t queued(0);
+        while (queued < part.length_) {
+            if (!wait(lane, lock, [this, &lane]() {
+            return lane.size_ < capacity_ || lane.error_ != 0;
+            })) {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            if (lane.error_ != 0) {
+                errno = lane.error_ > 0 ? lane.error_ : ECONNRESET;
+                return -1;
+            }
+            const size_t tail = (lane.head_ + lane.size_) % capacity_;
+            const size_t chunk = std::min(part.length_ - queued,
+                                          std::min(capacity_ - lane.size_, capacity_ - tail));
+            if (part.data_) {
+                memcpy(&lane.buf_[tail], part.data_ + queued, chunk);
+            } else {
+                memset(&lane.buf_[tail], 0, chunk);
+            }
+            lane.size_ += chunk;
+            queued += chunk;
+            lane.cv_.notify_all();
+        }
+        total += part.length_;
+    }
+    return static_cast<int>(total);
+}
+
+int ThreadedTransport::receive(size_t idx, char *data, int length)
+{
+    auto &lane = *lanes_[idx];
+    std::unique_lock<std::mutex> lock(lane.mutex_);
+    size_t received(0);
+    while (received < static_cast<size_t>(length)) {
+        if (!wait(lane, lock, [&lane]() {
+        return lane.size_ > 0 || lane.error_ != 0;
+        })) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (0 == lane.size_) {
+            errno = lane.error_ > 0 ? lane.error_ : ECONNRESET;
+            return -1;
+        }
+        const size_t chunk = std::min(static_cast<size_t>(length) - received,
+                                      std::min(lane.size_, capacity_ - lane.head_));
+        memcpy(data + received, &lane.buf_[lane.head_], chunk);
+        lane.head_ = (lane.head_ + chunk) % capacity_;
+        lane.size_ -= chunk;
+        received += chunk;
+        lane.cv_.notify_all();
+    }
+    return length;
+}
+
+bool ThreadedTransport::flush()
+{
+    for (auto &lane : lanes_) {
+        std::unique_lock<std::mutex> lock(lane->mutex_);
+        Lane &l = *lane;
+        if (!wait(l, lock, [&l]() {
+        return 0 == l.size_ || l.error_ != 0;
+        })) {
+            errno = ETIMEDOUT;
+            return false;
+        }
+        if (l.error_ != 0) {
+            errno = l.error_ > 0 ? l.error_ : ECONNRESET;
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ThreadedTransport::queued(size_t idx) const
+{
+    auto &lane = *lanes_[idx];
+    std::lock_guard<std::mutex> lock(lane.mutex_);
+    return lane.size_;
+}
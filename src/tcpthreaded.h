@@ -0,0 +1,82 @@
+/** @file tcpthreaded.h
+ * @brief Engine of TCPClient with a worker thread per socket
+ */
+#ifndef TCPTHREADED_H
+#define TCPTHREADED_H
+
+#include "tcptransport.h"
+
+#include <thread>
+#include <condition_variable>
+
+/**
+ * @class ThreadedTransport
+ * @brief Every socket has its own worker thread and queue, so all sockets are written
+ * (read) at the same time on multi-core hosts.
+ * @par Block number N of the session is queued to the lane N % nSockets by TCPClient (round-robin),
+ * so the order of blocks is restored on the receive side by taking the blocks from the lanes
+ * by turns. The receive workers read ahead up to the size of queue.
+ * @par A worker blocked in send/recv is released when the socket is shut down by
+ * TCPClient::disconnect().
+ */
+class ThreadedTransport : public BlockTransport
+{
+public:
+    /**
+     * @brief Constructor
+     * @param sockets - sockets of one direction
+     * @param isReceive - true for receive sockets, false for send sockets
+     * @param blockSize - size of TCP block in bytes
+     * @param queueDepth - size of queue of every socket in blocks
+     * @param timeOutSec - time out of waiting of socket, seconds (0 - infinite)
+     */
+    ThreadedTransport(const std::vector<DS_SOCKET> &sockets, const bool isReceive, const uint32_t blockSize,
+                      const uint32_t queueDepth, const int timeOutSec);
+    /// Destructor, stops the workers
+    virtual ~ThreadedTransport();
+    /**
+     * @brief Start the worker threads
+     * @return false if a thread is not started
+     */
+    bool init();
+    virtual int sendv(size_t lane, const DataPart *parts, size_t count);
+    virtual int receive(size_t lane, char *data, int length);
+    virtual bool flush();
+    virtual size_t queued(size_t lane) const;
+    virtual const char *name() const
+    {
+        return "threads";
+    }
+
+private:
+    /// Queue and worker of one socket
+    struct Lane {
+        DS_SOCKET sock_;
+        /// Ring buffer of data
+        std::vector<char> buf_;
+        /// Offset of first queued byte
+        size_t head_;
+        /// Count of queued bytes
+        size_t size_;
+        /// Error of socket (errno), -1 if connection is closed by server
+        int error_;
+        bool stop_;
+        std::mutex mutex_;
+        /// Signalled when data is queued (taken) by the worker or by TCPClient
+        std::condition_variable cv_;
+        std::thread worker_;
+        Lane() : sock_(0), head_(0), size_(0), error_(0), stop_(false) {}
+    };
+    void send_worker(Lane &lane);
+    void receive_worker(Lane &lane);
+    /// Wait of condition of lane with time out, false if time out
+    template <typename Predicate>
+    bool wait(Lane &lane, std::unique_lock<std::mutex> &lock, Predicate pred);
+
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    bool isReceive_;
+    size_t capacity_;
+    int timeOutSec_;
+};
+
+#endif // TCPTHREADED_H
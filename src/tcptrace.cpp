@@ -0,0 +1,195 @@
+#include "tcptrace.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+struct TraceEvent {
+    const char *name_;
+    const char *category_;
+    const char *argName_;
+    int64_t arg_;
+    uint64_t start_;
+    uint64_t end_;
+};
+
+/// Events of one thread, only this thread puts them
+struct ThreadBuffer {
+    /// Not initialized, the pages are taken by the first events only
+    std::unique_ptr<TraceEvent[]> events_;
+    size_t capacity_;
+    /// Count of events, published with release for the writer of trace
+    std::atomic<size_t> count_;
+    std::atomic<uint64_t> dropped_;
+    /// The thread puts an event (or its name), the buffer is not read or reset at this time
+    std::atomic<bool> busy_;
+    std::string name_;
+    uint32_t tid_;
+    ThreadBuffer() : capacity_(0), count_(0), dropped_(0), busy_(false), tid_(0) {}
+    /// Allocate "capacity" events, under buffersMutex while no thread records
+    void allocate(const size_t capacity)
+    {
+        if (capacity != capacity_) {
+            events_.reset(new TraceEvent[capacity]);
+            capacity_ = capacity;
+        }
+    }
+};
+
+/// The buffers are never freed, so the pointers of threads stay valid after stop()
+std::mutex buffersMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+std::string traceFile;
+size_t eventsPerThread(0);
+uint64_t traceStart(0);
+thread_local ThreadBuffer *threadBuffer = nullptr;
+
+ThreadBuffer &bufferOfThread()
+{
+    if (threadBuffer == nullptr) {
+        std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffer->tid_ = static_cast<uint32_t>(buffers.size() + 1);
+        buffer->name_ = "thread " + std::to_string(buffer->tid_);
+        buffer->allocate(eventsPerThread);
+        threadBuffer = buffer.get();
+        buffers.push_back(std::move(buffer));
+    }
+    return *threadBuffer;
+}
+
+/// Wait for the threads which have started to put an event before the recording is disabled, under buffersMutex
+void waitRecorders()
+{
+    for (const auto &buffer : buffers) {
+        while (buffer->busy_.load()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+std::string escape(const std::string &str)
+{
+    std::string res;
+    for (const auto c : str) {
+        if ('"' == c || '\\' == c) {
+            res += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            res += c;
+        }
+    }
+    return res;
+}
+
+/// Microseconds since start of trace
+double toUs(const uint64_t ticks)
+{
+    return ticks > traceStart ? double(instrument::to_ns(ticks - traceStart)) / 1000 : 0;
+}
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_(false);
+
+void Tracer::start(const std::string &fileName, const size_t eventsPerThreadIn)
+{
+    enabled_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        waitRecorders();
+        traceFile = fileName;
+        eventsPerThread = eventsPerThreadIn;
+        for (auto &buffer : buffers) {
+            buffer->allocate(eventsPerThread);
+            buffer->count_.store(0, std::memory_order_relaxed);
+            buffer->dropped_.store(0, std::memory_order_relaxed);
+        }
+    }
+    instrument::ns_per_tick();
+    traceStart = instrument::ticks();
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Tracer::set_thread_name(const std::string &name)
+{
+    if (!enabled()) {
+        return;
+    }
+    auto &buffer = bufferOfThread();
+    // pairs with stop(): either the flag is seen by stop() or the disabled recording is seen here
+    buffer.busy_.store(true);
+    if (enabled_.load()) {
+        buffer.name_ = name;
+    }
+    buffer.busy_.store(false, std::memory_order_release);
+}
+
+void Tracer::record(const char *name, const char *category, const uint64_t start, const uint64_t end,
+                    const char *argName, const int64_t arg)
+{
+    if (!enabled()) {
+        return;
+    }
+    auto &buffer = bufferOfThread();
+    buffer.busy_.store(true);
+    if (!enabled_.load()) {
+        buffer.busy_.store(false, std::memory_order_release);
+        return;
+    }
+    const auto n = buffer.count_.load(std::memory_order_relaxed);
+    if (n < buffer.capacity_) {
+        buffer.events_[n] = TraceEvent{ name, category, argName, arg, start, end };
+        buffer.count_.store(n + 1, std::memory_order_release);
+    } else {
+        buffer.dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    buffer.busy_.store(false, std::memory_order_release);
+}
+
+bool Tracer::stop()
+{
+    if (!enabled_.exchange(false)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    waitRecorders();
+    std::ofstream ofs(traceFile, std::ofstream::out | std::ofstream::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "File \"" << traceFile << "\" not created." << std::endl;
+        return false;
+    }
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    ofs << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"tcp_client\"}}";
+    uint64_t dropped(0);
+    for (const auto &buffer : buffers) {
+        const auto count = buffer->count_.load(std::memory_order_acquire);
+        if (0 == count) {
+            continue;
+        }
+        ofs << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid_
+            << ", \"args\": {\"name\": \"" << escape(buffer->name_) << "\"}}";
+        for (size_t i = 0; i < count; ++i) {
+            const auto &ev = buffer->events_[i];
+            ofs << ",\n{\"name\": \"" << ev.name_ << "\", \"cat\": \"" << ev.category_ << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                << buffer->tid_ << ", \"ts\": " << toUs(ev.start_) << ", \"dur\": " << toUs(ev.end_) - toUs(ev.start_);
+            if (ev.argName_) {
+                ofs << ", \"args\": {\"" << ev.argName_ << "\": " << ev.arg_ << "}";
+            }
+            ofs << "}";
+        }
+        dropped += buffer->dropped_.load(std::memory_order_relaxed);
+    }
+    ofs << "\n]}\n";
+    std::cout << "Trace:                             " << traceFile;
+    if (dropped > 0) {
+        std::cout << " (" << dropped << " events are dropped, the buffers are full)";
+    }
+    std::cout << std::endl;
+    return ofs.good();
+}
@@ -0,0 +1,88 @@
+/** @file tcptrace.h
+ * @brief Timeline of send/receive activity in Chrome trace-event format (chrome://tracing, Perfetto)
+ */
+#ifndef TCPTRACE_H
+#define TCPTRACE_H
+
+#include "tcpinstrument.h"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+/**
+ * @class Tracer
+ * @brief Recorder of spans of every thread. Every thread has its own buffer of events, the buffer
+ * is taken from the common list and allocated once (under lock), the events are put without lock.
+ * The buffers are written to the file by stop().
+ * @par The buffer of thread has a fixed size, the events after it is full are dropped and counted.
+ * The thread marks its buffer as busy while it puts an event, stop() and start() wait for it.
+ */
+class Tracer
+{
+public:
+    /// Start recording of events, the trace is written to fileName by stop()
+    static void start(const std::string &fileName, const size_t eventsPerThread = size_t(1) << 18);
+    /// Stop recording, wait for the threads which put an event and write the trace
+    static bool stop();
+    static bool enabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    /// Name of calling thread in the trace
+    static void set_thread_name(const std::string &name);
+    /**
+     * @brief Put span of calling thread
+     * @param name, category - string literals (they are kept as pointers)
+     * @param start, end - ticks of instrument::ticks()
+     * @param argName - name of argument of span, nullptr - no argument
+     */
+    static void record(const char *name, const char *category, const uint64_t start, const uint64_t end,
+                       const char *argName, const int64_t arg);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * @class TraceSpan
+ * @brief Span from construction to destruction, nothing is done if the tracing is off
+ * @code
+ * TraceSpan span("send", "net", "lane", idxSocket);
+ * @endcode
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name, const char *category, const char *argName = nullptr, const int64_t arg = 0)
+        : name_(name)
+        , category_(category)
+        , argName_(argName)
+        , arg_(arg)
+        , start_(Tracer::enabled() ? instrument::ticks() : 0)
+    {
+    }
+    ~TraceSpan()
+    {
+        end();
+    }
+    /// End the span before the end of scope
+    void end()
+    {
+        if (start_ != 0) {
+            Tracer::record(name_, category_, start_, instrument::ticks(), argName_, arg_);
+            start_ = 0;
+        }
+    }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name_;
+    const char *category_;
+    const char *argName_;
+    int64_t arg_;
+    uint64_t start_;
+};
+
+#endif // TCPTRACE_H
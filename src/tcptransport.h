@@ -0,0 +1,61 @@
+/** @file tcptransport.h
+ * @brief Interface of the engines which move blocks between TCPClient and sockets
+ */
+#ifndef TCPTRANSPORT_H
+#define TCPTRANSPORT_H
+
+#include "tcpclient.h"
+
+/**
+ * @class BlockTransport
+ * @brief Moves data over a set of sockets (lanes) of one direction.
+ * @par TCPClient keeps one instance for the send sockets and one for the receive sockets,
+ * so an instance is used from one thread only. The lane is chosen by TCPClient.
+ */
+class BlockTransport
+{
+public:
+    virtual ~BlockTransport() {}
+    /**
+     * @brief Send data to the lane
+     * @param lane - index of socket in the send sockets
+     * @param data - pointer to data
+     * @param length - length of data
+     * @return -1 - if error, else count of accepted bytes
+     */
+    int send(size_t lane, const char *data, int length)
+    {
+        const DataPart part = { data, static_cast<size_t>(length) };
+        return sendv(lane, &part, 1);
+    }
+    /**
+     * @brief Send several parts of data to the lane one after another
+     * @param lane - index of socket in the send sockets
+     * @param parts - parts of data
+     * @param count - count of parts
+     * @return -1 - if error, else count of accepted bytes
+     */
+    virtual int sendv(size_t lane, const DataPart *parts, size_t count) = 0;
+    /**
+     * @brief Receive \"length\" bytes of data from the lane
+     * @param lane - index of socket in the receive sockets
+     * @param data - pointer to data for reading
+     * @param length - count of bytes for reading
+     * @return -1 - if error, else count of received bytes
+     */
+    virtual int receive(size_t lane, char *data, int length) = 0;
+    /**
+     * @brief Wait until all accepted data is written to the sockets
+     * @return true if all data is written, false if error
+     */
+    virtual bool flush() = 0;
+    /// Count of bytes which are accepted for the lane and are not written to its socket yet
+    virtual size_t queued(size_t /*lane*/) const
+    {
+        return 0;
+    }
+    /// Name of engine for output
+    virtual const char *name() const = 0;
+};
+
+#endif // TCPTRANSPORT_H
@@ -0,0 +1,224 @@
+#include "tcpzerocopy.h"
+
+#include <iostream>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <linux/errqueue.h>
+#endif
+
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define TCPCLIENT_HAVE_ZEROCOPY
+#endif
+
+ZeroCopySender::ZeroCopySender(const std::vector<DS_SOCKET> &sockets, const int timeOutSec)
+    : lanes_(sockets.size())
+    , timeOutMs_(timeOutSec > 0 ? timeOutSec * 1000 : -1)
+    , sent_(0)
+    , copied_(0)
+{
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        lanes_[i].sock_ = sockets[i];
+    }
+}
+
+ZeroCopySender::~ZeroCopySender()
+{
+    for (auto &lane : lanes_) {
+        for (auto &block : lane.pending_) {
+            if (block.second) {
+                block.second();
+            }
+        }
+        lane.pending_.clear();
+    }
+    if (copied_ > 0) {
+        std::cout << "Zero-copy: " << copied_ << " of " << sent_ << " sendings were copied by kernel" << std::endl;
+    }
+}
+
+size_t ZeroCopySender::pending() const
+{
+    size_t count(0);
+    for (const auto &lane : lanes_) {
+        count += lane.pending_.size();
+    }
+    return count;
+}
+
+bool ZeroCopySender::flush()
+{
+    while (pending() > 0) {
+        if (!poll(true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef TCPCLIENT_HAVE_ZEROCOPY
+
+bool ZeroCopySender::init()
+{
+    const int one(1);
+    for (const auto &lane : lanes_) {
+        if (setsockopt(static_cast<int>(lane.sock_), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+            std::cerr << errno << ": Error set SO_ZEROCOPY." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int ZeroCopySender::send(size_t idx, const char *data, int length, const SendCompletion &done)
+{
+    auto &lane = lanes_[idx];
+    int sent(0);
+    while (sent < length) {
+        auto bytes = ::send(static_cast<int>(lane.sock_), data + sent, static_cast<size_t>(length - sent),
+                            MSG_ZEROCOPY | MSG_NOSIGNAL);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // the pinned pages are over the limit of socket, wait until the kernel releases some
+            if (errno == ENOBUFS && pending() > 0) {
+                if (!poll(true)) {
+                    return -1;
+                }
+                continue;
+            }
+            return -1;
+        }
+        // every successful call gets next id, even if it is a partial write
+        ++lane.nextId_;
+        ++sent_;
+        sent += static_cast<int>(bytes);
+    }
+    lane.pending_.emplace_back(lane.nextId_ - 1, done);
+    return poll(false) ? sent : -1;
+}
+
+bool ZeroCopySender::reap(Lane &lane)
+{
+    for (;;) {
+        char control[CMSG_SPACE(sizeof(struct sock_extended_err)) * 2];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(static_cast<int>(lane.sock_), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << errno << ": Error read of zero-copy completions." << std::endl;
+            return false;
+        }
+        for (auto cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                    (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            struct sock_extended_err serr;
+            memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+            if (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                std::cerr << serr.ee_errno << ": Error on socket error queue." << std::endl;
+                return false;
+            }
+            // ids [ee_info, ee_data] are completed, they are reported in order for TCP
+            ++lane.notices_;
+            if (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                copied_ += serr.ee_data - serr.ee_info + 1;
+            }
+            while (!lane.pending_.empty() &&
+                    static_cast<int32_t>(serr.ee_data - lane.pending_.front().first) >= 0) {
+                auto done = std::move(lane.pending_.front().second);
+                lane.pending_.pop_front();
+                if (done) {
+                    done();
+                }
+            }
+        }
+    }
+}
+
+bool ZeroCopySender::poll(const bool wait)
+{
+    std::vector<struct pollfd> fds;
+    std::vector<Lane *> waited;
+    for (auto &lane : lanes_) {
+        if (lane.pending_.empty()) {
+            continue;
+        }
+        if (!reap(lane)) {
+            return false;
+        }
+        if (wait && !lane.pending_.empty()) {
+            // the error queue is signalled by POLLERR, it is not requested in events
+            struct pollfd pfd = { static_cast<int>(lane.sock_), 0, 0 };
+            fds.push_back(pfd);
+            waited.push_back(&lane);
+        }
+    }
+    if (fds.empty()) {
+        return true;
+    }
+    int ret;
+    do {
+        ret = ::poll(fds.data(), fds.size(), timeOutMs_);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        std::cerr << errno << ": Error wait of zero-copy completions." << std::endl;
+        return false;
+    }
+    if (0 == ret) {
+        errno = ETIMEDOUT;
+        std::cerr << errno << ": Time out of zero-copy completions." << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < fds.size(); ++i) {
+        if (0 == fds[i].revents) {
+            continue;
+        }
+        auto before = waited[i]->notices_;
+        if (!reap(*waited[i])) {
+            return false;
+        }
+        if (before == waited[i]->notices_) {
+            // POLLERR without notifications is an error of socket
+            int err(0);
+            socklen_t len(sizeof(err));
+            getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            std::cerr << err << ": Error of socket while waiting of zero-copy completions." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+#else // not TCPCLIENT_HAVE_ZEROCOPY
+
+bool ZeroCopySender::init()
+{
+    return false;
+}
+
+int ZeroCopySender::send(size_t, const char *, int, const SendCompletion &)
+{
+    return -1;
+}
+
+bool ZeroCopySender::reap(Lane &)
+{
+    return false;
+}
+
+bool ZeroCopySender::poll(const bool)
+{
+    return false;
+}
+
+#endif // TCPCLIENT_HAVE_ZEROCOPY
@@ -0,0 +1,84 @@
+/** @file tcpzerocopy.h
+ * @brief Zero-copy (MSG_ZEROCOPY) sending for TCPClient
+ */
+#ifndef TCPZEROCOPY_H
+#define TCPZEROCOPY_H
+
+#include "tcpclient.h"
+
+#include <deque>
+
+/**
+ * @class ZeroCopySender
+ * @brief Sends blocks with MSG_ZEROCOPY, the kernel takes the pages of the caller's buffer
+ * instead of copying them to the socket buffer.
+ * @par The buffer must not be changed until the kernel reports (on the error queue of the
+ * socket) that it is done with it. Every block has a completion which is called at that
+ * moment. Completions are called from send(), poll() and flush(), i.e. in the sending thread.
+ */
+class ZeroCopySender
+{
+public:
+    /**
+     * @brief Constructor
+     * @param sockets - send sockets
+     * @param timeOutSec - time out of waiting of completions, seconds (0 - infinite)
+     */
+    ZeroCopySender(const std::vector<DS_SOCKET> &sockets, const int timeOutSec);
+    /// Destructor, calls completions of all blocks which are not completed yet
+    ~ZeroCopySender();
+    /**
+     * @brief Enable SO_ZEROCOPY on the sockets
+     * @return false if zero-copy is not supported by system
+     */
+    bool init();
+    /**
+     * @brief Send data to the lane with MSG_ZEROCOPY
+     * @param lane - index of socket in the send sockets
+     * @param data - pointer to data, must be kept until "done" is called
+     * @param length - length of data
+     * @param done - completion of block
+     * @return -1 - if error, else count of sending bytes
+     */
+    int send(size_t lane, const char *data, int length, const SendCompletion &done);
+    /**
+     * @brief Process completions of the kernel
+     * @param wait - wait for at least one completion if there are pending blocks
+     * @return false if error
+     */
+    bool poll(const bool wait);
+    /**
+     * @brief Wait of completions of all sent blocks
+     * @return false if error
+     */
+    bool flush();
+    /// Count of blocks which are not completed
+    size_t pending() const;
+    /// Count of sendings which the kernel has copied anyway (e.g. loopback)
+    uint64_t copied() const
+    {
+        return copied_;
+    }
+
+private:
+    /// Blocks of one socket in order of sending
+    struct Lane {
+        DS_SOCKET sock_;
+        /// Id of next zero-copy send call, the kernel counts them per socket
+        uint32_t nextId_;
+        /// Id of last send call of block and its completion
+        std::deque<std::pair<uint32_t, SendCompletion>> pending_;
+        /// Count of read notifications
+        uint64_t notices_;
+        Lane() : sock_(0), nextId_(0), notices_(0) {}
+    };
+    /// Read all notifications of the lane from the error queue
+    bool reap(Lane &lane);
+
+    std::vector<Lane> lanes_;
+    int timeOutMs_;
+    uint64_t sent_;
+    uint64_t copied_;
+};
+
+#endif // TCPZEROCOPY_H